@@ -43,6 +43,18 @@
  *  2019/02/03 Modified by Tamakichi 
  *  2019/02/08 Modified by Tamakichi,support Arduino STM32
  *  2019/02/10 Modified by Tamakichi,add FILES cimmand (FILES [start[,last]])
+ *  2026/10/18 add PASTE command (bulk program load without echo)
+ *  2026/10/18 add COLOR, ATTR commands (COLOR fc[,bc], ATTR n)
+ *  2026/10/18 add REMOTE command (framed console protocol for automated hosts)
+ *  2026/10/18 add line pointer access for page scrolling in the screen editor
+ *  2026/10/18 SAVE writes only the program length, reports flash write errors
+ *  2026/10/18 programs are kept in a log-structured flash store (SAVE/LOAD 0-15)
+ *  2026/10/18 add FLASH command (erase count of each program store page)
+ *  2026/10/18 LOAD runs the saved program in place from flash (copied to RAM on edit)
+ *  2026/10/18 add optional LZ compression of saved programs (FLASH_COMPRESS)
+ *  2026/10/18 PASTE: CTRL-C discards the staged lines, errors show the BASIC line number
+ *  2026/10/18 old fixed-slot program store is kept read-only until FLASH NEW formats it
+ *  2026/10/18 integer tokens are stored as int32_t (same token layout in a 64-bit host build)
  */
  
 // 日本語訳
@@ -111,9 +123,22 @@ int sysSTACKSTART, sysSTACKEND;
 int sysVARSTART, sysVAREND;
 int sysGOSUBSTART, sysGOSUBEND;
 
+// フラッシュメモリ上のプログラムの直接実行
+//  LOADしたプログラムはmem[]に複写せず、フラッシュメモリ上の格納位置のまま実行・参照する。
+//  行の登録・削除、SAVEの前にprogToRAM()でmem[]に複写する
+static unsigned char *progFlash = NULL;   // フラッシュメモリ上のプログラム(NULL:mem[]上のプログラム)
+static uint16_t progFlashLen;             // フラッシュメモリ上のプログラム長
+
+#define PROG_TOP  (progFlash ? progFlash : &mem[0])                          // プログラム先頭
+#define PROG_END  (progFlash ? progFlash + progFlashLen : &mem[sysPROGEND])  // プログラム終端
+
 int16_t getNextLineNo(int16_t lineno);
 char* getLineStr(int16_t lineno);
 int16_t getPrevLineNo(int16_t lineno);
+unsigned char* getLinePtr(uint16_t lineno);
+unsigned char* getNextLinePtr(unsigned char* p);
+char* getLinePtrStr(unsigned char* p);
+unsigned char* getPageTopLinePtr(uint16_t lineno, uint16_t width, uint16_t rows);
 
 const char* const errorTable[] = {
     "OK",
@@ -141,6 +166,9 @@ const char* const errorTable[] = {
     "Bad string index",
     "Error in VAL input",
     "Bad parameter",
+    "Flash write error",
+    "Flash full",
+    "Old flash format",
 };
 
 // Token flags (トークンフォーマット）
@@ -181,7 +209,9 @@ const TokenTableEntry tokenTable[] = {
     {"POSITION", TKN_FMT_POST},  {"PIN",TKN_FMT_POST}, {"PINMODE", TKN_FMT_POST}, {"INKEY$", 0},
     {"SAVE", TKN_FMT_POST}, {"LOAD", TKN_FMT_POST}, {"PINREAD",1}, {"ANALOGRD",1},
 //    {"DIR", TKN_FMT_POST}, {"DELETE", TKN_FMT_POST}
-    {"FILES", TKN_FMT_POST}, {"DELETE", TKN_FMT_POST}
+    {"FILES", TKN_FMT_POST}, {"DELETE", TKN_FMT_POST}, {"PASTE", TKN_FMT_POST},
+    {"COLOR", TKN_FMT_POST}, {"ATTR", TKN_FMT_POST}, {"REMOTE", TKN_FMT_POST},
+    {"FLASH", TKN_FMT_POST}
 };
 
 
@@ -207,7 +237,7 @@ void printTokens(unsigned char *p, uint8_t devno) {
             p+=4;
         } else if (*p == TOKEN_INTEGER) {     // 整数
             p++;
-            host_outputInt(*(long*)p,devno);
+            host_outputInt(*(int32_t*)p,devno);
             p+=4;
         } else if (*p == TOKEN_STRING) {      // 文字列
           p++;
@@ -237,6 +267,30 @@ void printTokens(unsigned char *p, uint8_t devno) {
     }
 }
 
+// 1行分トークンの画面出力
+// テキストバッファに変換してからまとめて出力する(バッファに収まらない場合は直接出力)
+// 引数
+//  p       : トークンへのポインタ
+//  lineNum : 先頭に付加する行番号(0:付加しない)
+//
+void printTokensLine(unsigned char *p, uint16_t lineNum) {
+    cleartbuf();
+    if (lineNum) {
+        host_outputInt(lineNum,CDEV_MEMORY);  // 行番号出力
+        host_outputChar(' ',CDEV_MEMORY);     // 空白出力
+    }
+    printTokens(p,CDEV_MEMORY);
+    if (gettbufLen() < MAXTEXTLEN) {
+        host_outputString(gettbuf(),CDEV_SCREEN);
+    } else {
+        if (lineNum) {
+            host_outputInt(lineNum,CDEV_SCREEN);
+            host_outputChar(' ',CDEV_SCREEN);
+        }
+        printTokens(p,CDEV_SCREEN);
+    }
+}
+
 // プログラムリスト出力
 // 引数
 //   first : 出力開始行番号
@@ -245,13 +299,11 @@ void printTokens(unsigned char *p, uint8_t devno) {
 //   p: [1行のバイト長 2バイト][行番号 2バイト][命令文]
 //
 void listProg(uint16_t first, uint16_t last) {
-    unsigned char *p = &mem[0];              // ポインタに先頭をセット
-    while (p < &mem[sysPROGEND]) {
+    unsigned char *p = PROG_TOP;             // ポインタに先頭をセット
+    while (p < PROG_END) {
         uint16_t lineNum = *(uint16_t*)(p+2);  // 行番号取得
         if ((!first || lineNum >= first) && (!last || lineNum <= last)) {
-            host_outputInt(lineNum,CDEV_SCREEN); // 行番号出力
-            host_outputChar(' ',CDEV_SCREEN);    // 空白出力
-            printTokens(p+4,CDEV_SCREEN);        // 1行分トークン出力
+            printTokensLine(p+4,lineNum);        // 行番号、1行分トークン出力
             host_newLine(CDEV_SCREEN);           // 改行
         }
         p+= *(uint16_t *)p;                    // ポインタを次の行に移動
@@ -265,8 +317,8 @@ void listProg(uint16_t first, uint16_t last) {
 //   p: [1行のバイト長 2バイト][行番号 2バイト][命令文]
 //
 unsigned char *findProgLine(uint16_t targetLineNumber) {
-    unsigned char *p = &mem[0];
-    while (p < &mem[sysPROGEND]) {
+    unsigned char *p = PROG_TOP;
+    while (p < PROG_END) {
         uint16_t lineNum = *(uint16_t*)(p+2);
         if (lineNum >= targetLineNumber)
             break;
@@ -296,6 +348,8 @@ void deleteProgLine(unsigned char *p) {
 //   0 登録した 、1 登録しなかった
 //
 int doProgLine(uint16_t lineNumber, unsigned char* tokenPtr, int tokensLength) {
+    progToRAM();                                  // フラッシュメモリ上のプログラムはRAMに複写して編集
+
     // find line of the at or immediately after the number (番号の位置、ない場合は挿入可能位置を検索）
     unsigned char *p = findProgLine(lineNumber);  // 指定行のポインタ取得
     uint16_t foundLine = 0;                       // 該当行番号
@@ -328,6 +382,163 @@ int doProgLine(uint16_t lineNumber, unsigned char* tokenPtr, int tokensLength) {
     return 1;                          // 登録完了
 }
 
+// プログラム行の一括登録(バッチ登録)
+//  - 登録する行をステージング領域に溜めておき、progBatchCommit()で行番号順に
+//    整列してプログラム領域に1パスでマージする
+//  - 同じ行番号の行は後から追加したものを有効とし、空行は行の削除として扱う
+//  - ステージング中は計算器スタック、変数領域を利用しないこと
+// (メモ)
+//   ステージング領域: [索引 4バイト×M][行 M個(追加順に上位から下位へ)]sysVARSTART
+//   行  : [1行のバイト長 2バイト][行番号 2バイト][命令文] (プログラム領域と同じ形式)
+//   索引: マージ時に作成
+//   マージ後のプログラム末尾がステージング領域に重ならないよう、
+//   sysPROGEND + 行の総バイト数×2 + 索引4バイト×M ≦ sysVARSTART を保つ
+//
+typedef struct {
+    uint16_t rec;   // ステージング行の位置
+    uint16_t pos;   // 挿入位置(不要行除去後のプログラム領域内)
+} StageIndex;
+
+static int stageBase;         // ステージング領域の上端
+static int stageBytes;        // ステージング行の総バイト数
+static int stageCount;        // ステージング行数
+static uint8_t stageActive;   // バッチ登録中
+
+#define STAGE_LINENO(e)  (*(uint16_t*)&mem[(e).rec+2])   // 索引が指す行の行番号
+
+// バッチ登録の開始
+void progBatchBegin() {
+    progToRAM();                  // フラッシュメモリ上のプログラムはRAMに複写して編集
+    stageBase = sysVARSTART;
+    stageBytes = 0;
+    stageCount = 0;
+    stageActive = 1;
+}
+
+// バッチ登録への1行追加
+//  - ステージング領域が満杯の場合は、それまでの行をマージしてから追加する
+//  - それでも追加できない場合は直接登録する
+// 引数
+//   lineNumber   : 行番号
+//   tokenPtr     : トークン先頭アドレス(ステージング領域外であること)
+//   tokensLength : トークン長さ
+// 戻り値
+//   1 追加した 、0 領域不足
+//
+int progBatchAdd(uint16_t lineNumber, unsigned char* tokenPtr, int tokensLength) {
+    if (!stageActive)
+        return doProgLine(lineNumber, tokenPtr, tokensLength);
+
+    int bytesNeeded = 4 + tokensLength;
+    if (sysPROGEND + 2*(stageBytes + bytesNeeded) + 4*(stageCount + 1) > stageBase) {
+        progBatchCommit();
+        progBatchBegin();
+        if (sysPROGEND + 2*bytesNeeded + 4 > stageBase) {
+            stageActive = 0;
+            int ret = doProgLine(lineNumber, tokenPtr, tokensLength);
+            progBatchBegin();
+            return ret;
+        }
+    }
+
+    stageBytes += bytesNeeded;
+    unsigned char *p = &mem[stageBase - stageBytes];
+    *(uint16_t *)p = bytesNeeded;
+    *(uint16_t *)(p+2) = lineNumber;
+    memcpy(p+4, tokenPtr, tokensLength);
+    stageCount++;
+    return 1;
+}
+
+// バッチ登録の中止
+//  - ステージング中の行を破棄する(ステージング領域不足で途中マージした行はプログラム領域に残る)
+void progBatchAbort() {
+    stageActive = 0;
+    stageCount = 0;
+    stageBytes = 0;
+}
+
+// バッチ登録の確定(プログラム領域へのマージ)
+void progBatchCommit() {
+    if (!stageActive)
+        return;
+    stageActive = 0;
+    if (!stageCount)
+        return;
+
+    // 索引の作成(行番号順の挿入ソート)
+    // ステージング行は新しい行ほど下位にあるため、索引には後ろから詰めて追加順(古い順)に並べてから整列する
+    // (行番号順に追加した場合は整列済みとなり、移動なしで済む)
+    // 同じ行番号では後から追加した(新しい)行を前に置く
+    StageIndex *idx = (StageIndex *)&mem[stageBase - stageBytes - sizeof(StageIndex)*stageCount];
+    int n = stageCount;
+    int rec = stageBase - stageBytes;
+    for (int i = n-1; i >= 0; i--) {
+        idx[i].rec = rec;
+        rec += *(uint16_t*)&mem[rec];
+    }
+    for (int k = 1; k < n; k++) {
+        StageIndex e = idx[k];
+        uint16_t lineNum = STAGE_LINENO(e);
+        int i = k;
+        while (i > 0 && STAGE_LINENO(idx[i-1]) >= lineNum) {
+            idx[i] = idx[i-1];
+            i--;
+        }
+        idx[i] = e;
+    }
+
+    // 同じ行番号の古い行を除き、追加するバイト数を求める
+    int m = 0, added = 0;
+    for (int i = 0; i < n; i++) {
+        if (m && STAGE_LINENO(idx[m-1]) == STAGE_LINENO(idx[i]))
+            continue;
+        idx[m] = idx[i];
+        if (mem[idx[m].rec+4] != TOKEN_EOL)
+            added += *(uint16_t*)&mem[idx[m].rec];
+        m++;
+    }
+
+    // 前方パス: 置換・削除対象の行を詰めて除き、各行の挿入位置を求める
+    unsigned char *src = &mem[0];
+    unsigned char *dst = &mem[0];
+    int j = 0;
+    while (src < &mem[sysPROGEND]) {
+        uint16_t lineLen = *(uint16_t*)src;
+        uint16_t lineNum = *(uint16_t*)(src+2);
+        while (j < m && STAGE_LINENO(idx[j]) < lineNum)
+            idx[j++].pos = dst - &mem[0];
+        if (j < m && STAGE_LINENO(idx[j]) == lineNum) {
+            idx[j++].pos = dst - &mem[0];          // 同じ行番号の行は除く
+        } else {
+            if (dst != src)
+                memmove(dst, src, lineLen);
+            dst += lineLen;
+        }
+        src += lineLen;
+    }
+    while (j < m)
+        idx[j++].pos = dst - &mem[0];
+
+    // 後方パス: 末尾から既存の行と追加行を配置する
+    unsigned char *srcEnd = dst;
+    unsigned char *wp = dst + added;
+    sysPROGEND = wp - &mem[0];
+    for (j = m-1; j >= 0; j--) {
+        unsigned char *ins = &mem[idx[j].pos];
+        int len = srcEnd - ins;
+        wp -= len;
+        memmove(wp, ins, len);
+        srcEnd = ins;
+        unsigned char *p = &mem[idx[j].rec];
+        if (p[4] != TOKEN_EOL) {
+            len = *(uint16_t*)p;
+            wp -= len;
+            memcpy(wp, p, len);
+        }
+    }
+}
+
 /* **************************************************************************
  * CALCULATOR STACK FUNCTIONS （計算器スタック操作関数）
  * **************************************************************************/
@@ -1129,12 +1340,12 @@ int nextToken() {
 
       if (!gotDecimal) {
           long val = strtol(numStr, 0, 10);
-          if (val == LONG_MAX || val == LONG_MIN)
+          if (val >= INT32_MAX || val <= INT32_MIN)
               gotDecimal = true;
           else {
               *tokenOut++ = TOKEN_INTEGER;
-              *(long*)tokenOut = (long)val;
-              tokenOut += sizeof(long);
+              *(int32_t*)tokenOut = (int32_t)val;
+              tokenOut += sizeof(int32_t);
           }
       }
 
@@ -1335,8 +1546,8 @@ int getNextToken() {
 
     } else if (curToken == TOKEN_INTEGER) {  // 整数値の場合
         // these are really just for line numbers
-        numVal = (float)(*(long*)tokenBuffer);
-        tokenBuffer += sizeof(long);
+        numVal = (float)(*(int32_t*)tokenBuffer);
+        tokenBuffer += sizeof(int32_t);
 
     } else if (curToken == TOKEN_STRING) {   // 文字列の場合
         strVal = (char*)tokenBuffer;
@@ -1358,6 +1569,10 @@ int getNextToken() {
 int parseExpression();
 int parsePrimary();
 int expectNumber();
+int parse_PASTE();
+int parse_COLOR();
+int parse_REMOTE();
+int parse_FLASH();
 
 // parse a number （数値を解析する）
 //  - 計算器スタックに数値(numVal)を積み、トークンバッファから次のトークンを取り出す
@@ -1408,6 +1623,118 @@ int parseSubscriptExpr() {
   return 0;
 }
 
+// VAL()の数値文字列の直接変換
+//  - 空白,負符号,数字,小数点のみからなる文字列を字句解析を介さずに数値に変換する
+//  - 字句解析と同じ規則で変換する(それ以外の書式は変換せず、通常の評価に任せる)
+//  - 単項の'+'は式の評価でエラーとなるため、ここでは変換しない
+//  - 字句解析は指数部を扱わず、"1E4"は1の後の変数E4として末尾が無視されるため、ここでは変換しない
+// 引数
+//  str : 文字列
+//  f   : 変換した数値の格納先
+// 戻り値
+//  1: 変換した 0: 変換対象外
+//
+static uint8_t valStrToNum(const char *str, float *f) {
+    const unsigned char *p = (const unsigned char *)str;
+    char numStr[MAX_NUMBER_LEN+1];
+    int numLen = 0;
+    uint8_t gotDecimal = 0, gotDigit = 0, neg = 0;
+
+    while (isspace(*p))
+        p++;
+    if (*p == '-') {
+        neg = 1;
+        p++;
+    }
+    while (isdigit(*p) || *p == '.') {
+        if (numLen == MAX_NUMBER_LEN)
+            return 0;
+        if (*p == '.') {
+            if (gotDecimal)
+                return 0;
+            gotDecimal = 1;
+        } else {
+            gotDigit = 1;
+        }
+        numStr[numLen++] = *p++;
+    }
+    if (!gotDigit)
+        return 0;
+    while (isspace(*p))
+        p++;
+    if (*p)
+        return 0;
+    numStr[numLen] = 0;
+
+    if (!gotDecimal) {
+        long val = strtol(numStr, 0, 10);
+        if (val >= INT32_MAX || val <= INT32_MIN)
+            gotDecimal = 1;
+        else
+            *f = (float)val;
+    }
+    if (gotDecimal)
+        *f = (float)strtod(numStr, 0);
+    if (neg)
+        *f = -*f;
+    return 1;
+}
+
+// VAL()のトークン化結果キャッシュ
+#define VALCACHE_NUM     4    // キャッシュ数
+#define VALCACHE_STRLEN  32   // 対象とする文字列の最大長
+#define VALCACHE_TOKLEN  48   // 対象とするトークン列の最大長
+
+typedef struct {
+    uint8_t tokLen;                        // トークン列長(0:未使用)
+    char str[VALCACHE_STRLEN+1];           // 文字列
+    unsigned char tok[VALCACHE_TOKLEN];    // トークン列
+} ValCacheEntry;
+
+static ValCacheEntry valCache[VALCACHE_NUM];
+static uint8_t valCacheNext;               // 次の登録位置
+
+// VAL()の文字列のトークン化(キャッシュ付き)
+//  - 文字列をトークン化し、&mem[sysSTACKEND]に格納する
+//  - tokenOutは格納したトークン列の終わりを指す
+// 引数
+//  str : 文字列
+// 戻り値
+//  0: 正常 1以上: tokenize()のエラーコード
+//
+static int valTokenize(char *str) {
+    unsigned char *out = &mem[sysSTACKEND];
+    int outSize = sysVARSTART - sysSTACKEND;
+    int len = strlen(str);
+
+    if (len <= VALCACHE_STRLEN) {
+        for (int i = 0; i < VALCACHE_NUM; i++) {
+            ValCacheEntry *e = &valCache[i];
+            if (e->tokLen && strcmp(e->str, str) == 0) {
+                if (e->tokLen >= outSize)
+                    return ERROR_LEXER_TOO_LONG;
+                memcpy(out, e->tok, e->tokLen);
+                tokenOut = out + e->tokLen;
+                return 0;
+            }
+        }
+    }
+
+    int val = tokenize((unsigned char*)str, out, outSize);
+    if (val)
+        return val;
+
+    int tokLen = tokenOut - out;
+    if (len <= VALCACHE_STRLEN && tokLen <= VALCACHE_TOKLEN) {
+        ValCacheEntry *e = &valCache[valCacheNext];
+        strcpy(e->str, str);
+        memcpy(e->tok, out, tokLen);
+        e->tokLen = tokLen;
+        valCacheNext = (valCacheNext + 1) % VALCACHE_NUM;
+    }
+    return 0;
+}
+
 // parse a function call e.g. LEN(a$)
 // 関数呼び出しの解析
 // 戻り値
@@ -1476,10 +1803,18 @@ int parseFnCallExpr() {
 
         case TOKEN_VAL:     // VAL(string) :string文字列を式として評価し、数値を得る
             {
+              // 数値のみの文字列は直接変換する
+              float f;
+              if (valStrToNum(stackGetStr(), &f)) {
+                  stackPopStr();
+                  stackPushNum(f);
+                  break;
+              }
+
               // tokenise str onto the stack(strをスタックにトークン化する)
               int oldStackEnd = sysSTACKEND;
               unsigned char *oldTokenBuffer = prevToken;
-              int val = tokenize((unsigned char*)stackGetStr(), &mem[sysSTACKEND], sysVARSTART - sysSTACKEND);
+              int val = valTokenize(stackGetStr());
               if (val) {
                   if (val == ERROR_LEXER_TOO_LONG) 
                       return ERROR_OUT_OF_MEMORY;
@@ -1509,7 +1844,7 @@ int parseFnCallExpr() {
                   return ERROR_EXPR_EXPECTED_NUM;
   
               // read the result from the stack (スタックから結果を読み込む)
-              float f = stackPopNum();
+              f = stackPopNum();
   
               // pop the tokens from the stack (スタックからトークンをポップする)
               sysSTACKEND = oldStackEnd;
@@ -2038,6 +2373,50 @@ int parse_PAUSE() {
   return 0;
 }
 
+// COLOR、ATTR コマンドの処理
+//  書式 COLOR 文字色[,背景色]  (0～8、背景色省略時は0:黒)
+//       ATTR 属性             (0:標準 1:下線 2:反転 3:点滅 4:太字)
+//   正常終了 0
+//   異常終了 エラーコード
+//   
+int parse_COLOR() {
+  int op = curToken;
+  int val;
+  int fc, bc = 0;
+
+  getNextToken();
+
+  // 第1引数の評価
+  val = expectNumber();
+  if (val)
+      return val;	// error
+
+  // COLORの背景色(省略可能)の評価
+  if (op == TOKEN_COLOR && curToken == TOKEN_COMMA) {
+    getNextToken();
+    val = expectNumber();
+    if (val)
+        return val;	// error
+    if (executeMode)
+      bc = (int)stackPopNum();
+  }
+
+  // 実行モードの場合、属性の設定を行う
+  if (executeMode) {
+    fc = (int)stackPopNum();
+    if (op == TOKEN_COLOR) {
+      if (fc < 0 || fc > 8 || bc < 0 || bc > 8)
+        return ERROR_BAD_PARAMETER;
+      host_setColor(fc, bc);
+    } else {
+      if (fc < 0 || fc > 4)
+        return ERROR_BAD_PARAMETER;
+      host_setAttr(fc);
+    }
+  }
+  return 0;
+}
+
 // LIST コマンドの処理
 //  書式 LIST [start][,end]
 //   正常終了 0
@@ -2115,17 +2494,14 @@ int parseFILES() {
             return ERROR_BAD_PARAMETER; // error
         }
         
-        uint32_t flash_adr;
-        unsigned char *p;
+        unsigned char line[4+MAXTEXTLEN];            // 先頭行([長さ][行番号][命令文])
         for (uint16_t i=first ; i <= last; i++) {    
-            flash_adr = (uint32_t)FlashMan.getPrgAddress(i); // プログラム保存アドレスの取得
             host_outputInt(i,CDEV_SCREEN);                   // プログラム番号の出力
             host_outputChar(':',CDEV_SCREEN);
-            if(!FlashMan.isExistPrg(i)) {                    //  プログラム有無のチェック
+            if(!FlashMan.readPrg(i, line, sizeof(line))) {   // 先頭行の読込み(圧縮時は展開)
                 host_outputString("(none)",CDEV_SCREEN);
             } else {
-                p = (uint8_t*)flash_adr;
-                printTokens(p+4, CDEV_SCREEN);           // 行番号より後ろを文字列に変換して表示
+                printTokensLine(line+4, 0);              // 行番号より後ろを文字列に変換して表示
             } 
             host_newLine(CDEV_SCREEN);
         }                
@@ -2133,6 +2509,54 @@ int parseFILES() {
     return 0;
 }
 
+// FLASH コマンドの処理
+//  書式 FLASH
+//       FLASH NEW
+//   正常終了 0
+//   異常終了 エラーコード
+// プログラム保存領域のページ別消去回数(ページ番号:回数)と最小・最大を表示する
+// FLASH NEW は保存プログラムをすべて消去する(旧形式の保存領域はこれで保存可能になる)
+int parse_FLASH() {
+    getNextToken();
+    if (curToken == TOKEN_NEW) {
+        getNextToken();
+        if (executeMode) {
+            if (progFlash && lineNumber)
+                return ERROR_UNEXPECTED_CMD; // フラッシュメモリ上で実行中のプログラムからは消去しない
+            progToRAM();                     // LOADしたプログラムはRAMに残す
+            if (FlashMan.format())
+                return ERROR_FLASH_WRITE;
+        }
+        return 0;
+    }
+    if (executeMode) {
+        uint16_t n = FlashMan.getAreaPageNum();
+        uint16_t cnt, min = 0xffff, max = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            cnt = FlashMan.getEraseCount(i);
+            if (cnt < min) min = cnt;
+            if (cnt > max) max = cnt;
+            host_outputInt(i,CDEV_SCREEN);
+            host_outputChar(':',CDEV_SCREEN);
+            host_outputInt(cnt,CDEV_SCREEN);
+            if (i % 8 == 7 || i == n-1)
+                host_newLine(CDEV_SCREEN);
+            else
+                host_outputChar(' ',CDEV_SCREEN);
+        }
+        host_outputString("min ",CDEV_SCREEN);
+        host_outputInt(min,CDEV_SCREEN);
+        host_outputString(" max ",CDEV_SCREEN);
+        host_outputInt(max,CDEV_SCREEN);
+        host_newLine(CDEV_SCREEN);
+        if (FlashMan.isLegacy()) {
+            host_outputString("old format (FLASH NEW to format)",CDEV_SCREEN);
+            host_newLine(CDEV_SCREEN);
+        }
+    }
+    return 0;
+}
+
 // PRINT コマンドの処理
 //  書式 PRINT <expr>;<expr>...
 //   正常終了 0
@@ -2327,16 +2751,147 @@ int parseAssignment(bool inputStmt) {
     return 0;
 }
 
+// 比較演算の評価(条件判定用)
+// 比較結果を計算スタックに積まずに真偽値で返す
+//  引数
+//   BinOp  : 比較演算子トークン
+//   lhsVal : 左項の型
+//   rhsVal : 右項の型
+//   cond   : 比較結果の格納先(実行モード時のみ)
+//  戻り値
+//   正常終了 0
+//   異常終了 エラーコード
+//
+int compareOperands(int BinOp, int lhsVal, int rhsVal, bool *cond) {
+    if (IS_TYPE_NUM(lhsVal) && IS_TYPE_NUM(rhsVal)) {         // 数値の比較
+        if (executeMode) {
+            float r = stackPopNum();          // 右項
+            float l = stackPopNum();          // 左項
+            switch (BinOp) {
+            case TOKEN_EQUALS: *cond = (l == r); break;    // "="
+            case TOKEN_NOT_EQ: *cond = (l != r); break;    // "<>"
+            case TOKEN_GT:     *cond = (l >  r); break;    // ">"
+            case TOKEN_LT:     *cond = (l <  r); break;    // "<"
+            case TOKEN_GT_EQ:  *cond = (l >= r); break;    // ">="
+            case TOKEN_LT_EQ:  *cond = (l <= r); break;    // "<="
+            }
+        }
+    } else if (IS_TYPE_STR(lhsVal) && IS_TYPE_STR(rhsVal)) {  // 文字列の比較
+        if (executeMode) {
+            char *r = stackPopStr();          // 右項
+            char *l = stackPopStr();          // 左項
+            int ret = strcmp(l,r);            // 文字列比較
+            switch (BinOp) {
+            case TOKEN_EQUALS: *cond = (ret == 0); break;  // "="
+            case TOKEN_NOT_EQ: *cond = (ret != 0); break;  // "<>"
+            case TOKEN_GT:     *cond = (ret >  0); break;  // ">"
+            case TOKEN_LT:     *cond = (ret <  0); break;  // "<"
+            case TOKEN_GT_EQ:  *cond = (ret >= 0); break;  // ">="
+            case TOKEN_LT_EQ:  *cond = (ret <= 0); break;  // "<="
+            }
+        }
+    } else
+        return ERROR_UNEXPECTED_TOKEN;
+    return 0;
+}
+
+// 条件式の項の評価(条件判定用)
+// [算術式] または [算術式 比較演算子 算術式] を評価し、真偽値を返す
+// 比較の連鎖(A<B=C 等)は従来通り計算スタック上の数値として評価する
+//  引数
+//   cond : 評価結果の格納先(実行モード時のみ)
+//  戻り値
+//   正常終了 0、比較演算子を含まない文字列式の場合 TYPE_STRING
+//   異常終了 エラーコード
+//
+int parseConditionTerm(bool *cond) {
+    int lhsVal = parsePrimary();                // 左項の評価
+    if (lhsVal & ERROR_MASK)
+        return lhsVal;
+    lhsVal = parseBinOpRHS(30, lhsVal);         // 算術演算子(+,-,*,/,MOD)のみ処理
+    if (lhsVal & ERROR_MASK)
+        return lhsVal;
+
+    int TokPrec = getTokPrecedence();
+    if (TokPrec != 10 && TokPrec != 20) {       // 比較演算子を含まない
+        if (!IS_TYPE_NUM(lhsVal))
+            return TYPE_STRING;
+        if (executeMode)
+            *cond = (stackPopNum() != 0.0f);
+        return 0;
+    }
+
+    int BinOp = curToken;
+    getNextToken();                             // eat binop
+    int rhsVal = parsePrimary();                // 右項の評価
+    if (rhsVal & ERROR_MASK)
+        return rhsVal;
+    if (TokPrec < getTokPrecedence()) {         // 右項の後の演算子の方が結合が強い
+        rhsVal = parseBinOpRHS(TokPrec+1, rhsVal);
+        if (rhsVal & ERROR_MASK)
+            return rhsVal;
+    }
+    int ret = compareOperands(BinOp, lhsVal, rhsVal, cond);
+    if (ret)
+        return ret;
+
+    // 比較の連鎖は従来の評価に委ねる
+    if (getTokPrecedence() >= 10) {
+        if (executeMode)
+            stackPushNum(*cond ? 1.0f : 0.0f);
+        int val = parseBinOpRHS(10, TYPE_NUMBER);
+        if (val & ERROR_MASK)
+            return val;
+        if (!IS_TYPE_NUM(val))
+            return ERROR_UNEXPECTED_TOKEN;
+        if (executeMode)
+            *cond = (stackPopNum() != 0.0f);
+    }
+    return 0;
+}
+
+// 条件式の評価(IF文用)
+// 比較演算・AND・OR の結果を計算スタックを経由せずに真偽値で得る
+// (数値式としての評価結果の真偽とは同一となる)
+//  引数
+//   cond : 評価結果の格納先(実行モード時のみ)
+//  戻り値
+//   正常終了 0
+//   異常終了 エラーコード
+//
+int parseCondition(bool *cond) {
+    int ret = parseConditionTerm(cond);
+    if (ret & ERROR_MASK)
+        return ret;
+    if (ret == TYPE_STRING)
+        return (curToken == TOKEN_AND || curToken == TOKEN_OR) ? ERROR_UNEXPECTED_TOKEN : ERROR_EXPR_EXPECTED_NUM;
+
+    while (curToken == TOKEN_AND || curToken == TOKEN_OR) {
+        int BinOp = curToken;
+        bool rhs;
+        getNextToken();                         // eat AND/OR
+        ret = parseConditionTerm(&rhs);         // 右項は常に評価する(副作用を保つため)
+        if (ret & ERROR_MASK)
+            return ret;
+        if (ret == TYPE_STRING)
+            return ERROR_UNEXPECTED_TOKEN;
+        if (executeMode)
+            *cond = (BinOp == TOKEN_AND) ? (*cond && rhs) : (*cond || rhs);
+    }
+    return 0;
+}
+
 // IF 式 THEN の処理
 //  戻り値
 //   エラーコード
 //
 int parse_IF() {
+    bool cond = false;
 
-    // 式の評価
+    // 条件式の評価
     getNextToken();	// eat if
-    int val = expectNumber();
-    if (val) 
+    int val = parseCondition(&cond);
+    if (val)
         return val;	// error
 
     // THEN のチェック
@@ -2345,8 +2900,8 @@ int parse_IF() {
 
     getNextToken();
 
-    // 実行モードの場合、式の評価値が偽の場合、以降の処理をスキップ設定
-    if (executeMode && stackPopNum() == 0.0f) {
+    // 実行モードの場合、条件が偽の場合、以降の処理をスキップ設定
+    if (executeMode && !cond) {
         // condition not met
         breakCurrentLine = 1;
         return 0;
@@ -2522,7 +3077,12 @@ int parseLoadSaveCmd() {
             }
         }              
         if (op == TOKEN_SAVE) {
-          host_saveProgram(autoexec,flleNo);
+          if (progFlash && lineNumber)
+              return ERROR_UNEXPECTED_CMD; // フラッシュメモリ上で実行中のプログラムからは保存しない
+          progToRAM();
+          int ret = host_saveProgram(autoexec,flleNo);
+          if (ret)
+              return ret;
         } else if (op == TOKEN_LOAD) {
             reset();
             host_loadProgram(flleNo);
@@ -2669,6 +3229,19 @@ int parseStmts() {
         case TOKEN_FILES:
             ret = parseFILES();
             break;
+        case TOKEN_FLASH:
+            ret = parse_FLASH();
+            break;
+        case TOKEN_PASTE:
+            ret = parse_PASTE();
+            break;
+        case TOKEN_COLOR:
+        case TOKEN_ATTR:
+            ret = parse_COLOR();
+            break;
+        case TOKEN_REMOTE:
+            ret = parse_REMOTE();
+            break;
         
         // 整数型引数を２つもつコマンド
         case TOKEN_POSITION:
@@ -2724,6 +3297,351 @@ int parseStmts() {
     return ret;
 }
 
+// 行番号付きテキスト1行のプログラム領域への登録
+//  - トークン化済みの行の文法チェックを行い、プログラム領域に登録する
+//  - 解析用のグローバル変数(tokenBuffer、curToken等)を書き換える
+// 引数
+//  tokens  : トークン化済みの行
+//  pLineNo : 行番号の格納先(正しい行番号がない場合は0)
+// 戻り値
+//  エラーコード
+//
+static int enterProgLine(unsigned char *tokens, uint16_t *pLineNo) {
+    *pLineNo = 0;
+    tokenBuffer = tokens;
+    getNextToken();
+    if (curToken != TOKEN_INTEGER)
+        return ERROR_BAD_LINE_NUM;             // 行番号なし
+    long val = (long)numVal;
+    if (val > 65535)
+        return ERROR_LINE_NUM_TOO_BIG;
+    if (val == 0)
+        return ERROR_BAD_LINE_NUM;
+    *pLineNo = (uint16_t)val;
+
+    unsigned char *lineStartPtr = tokenBuffer;
+    getNextToken();
+    executeMode = 0;                           // 文法チェックのみ
+    targetStmtNumber = 0;
+    int ret = parseStmts();
+    executeMode = 1;
+    if (ret)
+        return ret;
+    if (!progBatchAdd((uint16_t)val, lineStartPtr, tokenBuffer - lineStartPtr))
+        return ERROR_OUT_OF_MEMORY;
+    return 0;
+}
+
+#define PASTE_ERR_MAX   4    // PASTEで個別に表示するエラー数
+
+static uint8_t remoteMode = 0;                 // REMOTEの要求処理中
+
+// PASTE コマンドの処理
+//  書式 PASTE
+//  - 行番号付きのプログラムテキストをエコーなしで受信し、プログラム領域に登録する
+//  - 1行受信毎にXOFFで送信を止め、登録後にXONで再開する
+//  - [CTRL-Z]、[CTRL-D]で終了、エラーと転送量は終了時にまとめて表示する
+//  - [CTRL-C]で中断し、受信した行を登録しない(メモリ不足で途中登録済みの行は残る)
+//  - エラーは行番号(行番号が得られない行は#受信行数)で表示する
+//  - 直接モードでのみ利用可能
+//   正常終了 0
+//   異常終了 エラーコード
+//
+int parse_PASTE() {
+    getNextToken();
+    if (!executeMode)
+        return 0;
+    if (lineNumber || remoteMode)
+        return ERROR_UNEXPECTED_CMD;           // プログラム中、REMOTE中では利用不可
+
+    char line[MAXTEXTLEN];                     // 受信行
+    unsigned char tokens[MAXTEXTLEN];          // トークン化した行
+    uint16_t errLine[PASTE_ERR_MAX];           // エラー発生行(行番号、0の場合は受信行)
+    uint16_t errRecv[PASTE_ERR_MAX];           // エラー発生受信行(何行目か)
+    uint8_t  errCode[PASTE_ERR_MAX];           // エラーコード
+    uint16_t lineNo = 0;
+    uint16_t lines = 0, errors = 0;
+    uint32_t bytes = 0;
+    uint32_t start = millis();
+    int16_t len;
+
+    progBatchBegin();
+    while ((len = host_readRawLine(line, MAXTEXTLEN)) >= 0) {
+        bytes += len + 1;
+        if (len) {
+            host_flowCtrl(false);              // 登録中は送信を止める
+            lines++;
+            int ret;
+            lineNo = 0;
+            if (len >= MAXTEXTLEN)
+                ret = ERROR_LEXER_TOO_LONG;
+            else if ((ret = tokenize((unsigned char*)line, tokens, MAXTEXTLEN)) == 0)
+                ret = enterProgLine(tokens, &lineNo);
+            if (ret) {
+                if (errors < PASTE_ERR_MAX) {
+                    errLine[errors] = lineNo;
+                    errRecv[errors] = lines;
+                    errCode[errors] = ret;
+                }
+                errors++;
+            }
+            host_flowCtrl(true);
+        }
+    }
+    if (len == -2) {
+        progBatchAbort();                      // [CTRL-C] 中断
+        host_outputString((char *)errorTable[ERROR_BREAK_PRESSED], CDEV_SCREEN);
+        host_newLine(CDEV_SCREEN);
+    } else {
+        progBatchCommit();
+    }
+
+    // 結果の表示
+    host_outputInt(lines, CDEV_SCREEN);
+    host_outputString((char *)" lines, ", CDEV_SCREEN);
+    host_outputInt(bytes, CDEV_SCREEN);
+    host_outputString((char *)" bytes, ", CDEV_SCREEN);
+    host_outputInt(millis() - start, CDEV_SCREEN);
+    host_outputString((char *)" ms", CDEV_SCREEN);
+    host_newLine(CDEV_SCREEN);
+    if (errors) {
+        host_outputInt(errors, CDEV_SCREEN);
+        host_outputString((char *)" errors", CDEV_SCREEN);
+        host_newLine(CDEV_SCREEN);
+        for (uint16_t i = 0; i < errors && i < PASTE_ERR_MAX; i++) {
+            if (errLine[i]) {
+                host_outputInt(errLine[i], CDEV_SCREEN);
+            } else {
+                host_outputChar('#', CDEV_SCREEN);
+                host_outputInt(errRecv[i], CDEV_SCREEN);
+            }
+            host_outputChar('-', CDEV_SCREEN);
+            host_outputString((char *)errorTable[errCode[i]], CDEV_SCREEN);
+            host_newLine(CDEV_SCREEN);
+        }
+    }
+    breakCurrentLine = 1;
+    return 0;
+}
+
+#define REMOTE_SYNC      0xA5  // フレームの先頭
+#define REMOTE_VERSION   1     // プロトコルの版数
+#define REMOTE_OUT_SIZE  64    // 出力フレームの最大ペイロード長
+
+static uint8_t remoteOut[REMOTE_OUT_SIZE];     // 出力フレームのペイロード
+static uint16_t remoteOutLen;                  // 出力フレームのペイロード長
+
+// 16ビット値のリトルエンディアン格納
+static uint8_t *remotePut16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+// 32ビット値のリトルエンディアン格納
+static uint8_t *remotePut32(uint8_t *p, uint32_t v) {
+    p = remotePut16(p, v);
+    return remotePut16(p, v >> 16);
+}
+
+// フレームヘッダの送信
+//  cmd : コマンド
+//  len : ペイロード長(続けてhost_writeRaw()で送信する)
+static void remoteSendHead(uint8_t cmd, uint16_t len) {
+    uint8_t head[4];
+    head[0] = REMOTE_SYNC;
+    remotePut16(head + 1, len);
+    head[3] = cmd;
+    host_writeRaw(head, 4);
+}
+
+// 出力フレームの送信
+static void remoteOutFlush() {
+    if (remoteOutLen) {
+        remoteSendHead('O', remoteOutLen);
+        host_writeRaw(remoteOut, remoteOutLen);
+        remoteOutLen = 0;
+    }
+}
+
+// 画面出力の横取り(出力フレームにまとめて送信する)
+static void remoteOutput(const char *str, uint16_t len) {
+    while (len--) {
+        if (remoteOutLen == REMOTE_OUT_SIZE)
+            remoteOutFlush();
+        remoteOut[remoteOutLen++] = *str++;
+    }
+}
+
+// REMOTE コマンドの処理(機械間通信用のフレーム形式コンソール)
+//  書式 REMOTE
+//  - 以降は端末の画面表示を介さずに、フレーム単位の要求を受信して応答を返す('Q'で終了)
+//  - フレーム(要求・応答共通、数値はリトルエンディアン)
+//      [0xA5][ペイロード長 u16][コマンド u8][ペイロード]
+//  - 開始時に 'R' [0][版数][最大ペイロード長 u16] を送信する
+//  - 要求と応答(応答ペイロードの先頭はbasic.hのエラーコード ERROR_xxx)
+//      'E' 1行実行   要求: テキスト1行(行番号付きの場合はプログラムに登録)
+//                    応答: PRINT等の出力の 'O' [テキスト] (0個以上) の後に 'E' [エラー][エラー行番号 u16]
+//      'U' 行の登録  要求: トークン化済みの行番号付き1行(tokenize()の出力形式)
+//                    応答: 'U' [エラー] (連続する登録はまとめてプログラム領域に反映する)
+//      'V' 変数参照  要求: 変数名(文字列変数は'$'付き)
+//                    応答: 'V' [エラー][型 0:数値 1:文字列][値(float 4バイト または 文字列)]
+//      'M' メモリ    応答: 'M' [0][プログラム u16][空き u16][変数 u16]
+//                          [送信累計 u32][送信待ち u32][送信滞留最大 u16][受信累計 u32][受信保留 u32][受信滞留最大 u16]
+//      'Q' 終了      応答: 'Q' [0]
+//    未定義のコマンドには [ERROR_UNEXPECTED_CMD]、長すぎる要求には [ERROR_LEXER_TOO_LONG] を返す
+//  - 実行の中断は[CTRL-C]の送信で行う(要求は応答を受けてから次を送ること)
+//  - 実行中のINPUTは中断扱い、INKEY$は常に空、CLS・POSITION・COLOR・ATTRは無視する
+//  - 直接モードでのみ利用可能
+//   正常終了 0
+//   異常終了 エラーコード
+//
+int parse_REMOTE() {
+    getNextToken();
+    if (!executeMode)
+        return 0;
+    if (lineNumber || remoteMode)
+        return ERROR_UNEXPECTED_CMD;           // プログラム中、REMOTE中では利用不可
+
+    unsigned char req[MAXTEXTLEN+1];           // 要求ペイロード(+終端)
+    unsigned char tokens[MAXTEXTLEN];          // トークン化した行
+    uint8_t res[32];                           // 応答ペイロード
+    uint8_t *p;
+    uint8_t head[3];
+    uint16_t len, n;
+    uint8_t cmd;
+    uint8_t batch = 0;                         // 行の登録をまとめている
+    int ret;
+
+    remoteMode = 1;
+    remoteOutLen = 0;
+    host_flush();
+    host_setOutputHook(remoteOutput);
+
+    res[0] = ERROR_NONE;
+    res[1] = REMOTE_VERSION;
+    remotePut16(res + 2, MAXTEXTLEN);
+    remoteSendHead('R', 4);
+    host_writeRaw(res, 4);
+    host_flush();
+
+    for (cmd = 0; cmd != 'Q'; ) {
+        // フレームの受信(先頭まで読み飛ばす)
+        do {
+            host_readBytes(head, 1);
+        } while (head[0] != REMOTE_SYNC);
+        host_readBytes(head, 3);
+        len = head[0] | (head[1] << 8);
+        cmd = head[2];
+        if (len > MAXTEXTLEN) {
+            for ( ; len; len -= n) {           // 長すぎる要求は読み捨てる
+                n = len < MAXTEXTLEN ? len : MAXTEXTLEN;
+                host_readBytes(req, n);
+            }
+            res[0] = ERROR_LEXER_TOO_LONG;
+            remoteSendHead(cmd, 1);
+            host_writeRaw(res, 1);
+            host_flush();
+            continue;
+        }
+        host_readBytes(req, len);
+        req[len] = 0;
+
+        if (batch && cmd != 'U') {
+            progBatchCommit();                 // 登録以外の要求の前にプログラム領域に反映
+            batch = 0;
+        }
+
+        p = res + 1;
+        switch (cmd) {
+        case 'E':                              // 1行実行
+            ret = tokenize(req, tokens, MAXTEXTLEN);
+            if (ret == ERROR_NONE)
+                ret = processInput(tokens);
+            remoteOutFlush();
+            p = remotePut16(p, ret ? lineNumber : 0);
+            lineNumber = 0;
+            executeMode = 1;
+            break;
+
+        case 'U': {                            // トークン化済みの行の登録
+            uint16_t lineNo;
+            if (!batch) {
+                progBatchBegin();
+                batch = 1;
+            }
+            ret = enterProgLine(req, &lineNo);
+            break;
+        }
+
+        case 'V': {                            // 変数の参照
+            char *str = NULL;
+            float f = FLT_MAX;
+            ret = ERROR_VARIABLE_NOT_FOUND;
+            if (len && req[len-1] == '$')
+                str = lookupStrVariable((char *)req);
+            else if (len)
+                f = lookupNumVariable((char *)req);
+            if (str) {
+                ret = ERROR_NONE;
+                res[0] = ret;
+                res[1] = 1;
+                n = strlen(str);
+                remoteSendHead(cmd, 2 + n);
+                host_writeRaw(res, 2);
+                host_writeRaw((uint8_t *)str, n);
+                host_flush();
+                continue;
+            }
+            if (f != FLT_MAX) {
+                ret = ERROR_NONE;
+                *p++ = 0;
+                memcpy(p, &f, 4);
+                p += 4;
+            }
+            break;
+        }
+
+        case 'M': {                            // メモリ・送受信の情報
+            uint32_t v1, v2;
+            uint16_t v3;
+            ret = ERROR_NONE;
+            p = remotePut16(p, PROG_END - PROG_TOP);
+            p = remotePut16(p, sysVARSTART - sysPROGEND);
+            p = remotePut16(p, sysVAREND - sysVARSTART);
+            host_getTxStat(&v1, &v2, &v3);
+            p = remotePut32(p, v1);
+            p = remotePut32(p, v2);
+            p = remotePut16(p, v3);
+            host_getRxStat(&v1, &v2, &v3);
+            p = remotePut32(p, v1);
+            p = remotePut32(p, v2);
+            p = remotePut16(p, v3);
+            break;
+        }
+
+        case 'Q':                              // 終了
+            ret = ERROR_NONE;
+            break;
+
+        default:
+            ret = ERROR_UNEXPECTED_CMD;
+            break;
+        }
+        res[0] = ret;
+        remoteSendHead(cmd, p - res);
+        host_writeRaw(res, p - res);
+        host_flush();
+    }
+
+    host_setOutputHook(NULL);
+    remoteMode = 0;
+    jumpLineNumber = 0;
+    jumpStmtNumber = 0;
+    breakCurrentLine = 1;
+    return 0;
+}
+
 // インタープリタの処理
 //  引数
 //    tokenBuf : 中間コードトークンバッファ
@@ -2823,7 +3741,7 @@ int processInput(unsigned char *tokenBuf) {
                 }
             
                 // end of program? （プログラムの終わりに達したか？）
-                if (p == &mem[sysPROGEND])
+                if (p == PROG_END)
                     break;	// end of program （プログラムの終了）
         
                 lineNumber = *(uint16_t*)(p+2);  // 行番号
@@ -2855,6 +3773,7 @@ void reset() {
     // program at the start of memory 
     // (プログラムはメモリの先頭から利用)
     sysPROGEND = 0;
+    progFlash = NULL;
   
     // stack is at the end of the program area 
     // (スタックはプログラム域の終わりにあります)
@@ -2871,6 +3790,34 @@ void reset() {
     lineNumber = 0;      // 行番号
 }
 
+// フラッシュメモリ上のプログラムの直接実行の設定
+// 引数
+//   p   : フラッシュメモリ上のプログラム先頭(mem[]と同じ形式)
+//   len : プログラム長
+// (メモ)
+//   reset()の後に呼び出す。mem[]はすべて変数、スタックに利用できる
+//
+void progSetFlash(unsigned char *p, uint16_t len) {
+    progFlash = len ? p : NULL;
+    progFlashLen = len;
+}
+
+// フラッシュメモリ上のプログラムのRAMへの複写
+// (メモ)
+//   行の登録・削除、SAVEの前に呼び出す(実行中は呼び出さないこと)。
+//   プログラムが変数領域と重なる場合は変数をクリアする
+//
+void progToRAM() {
+    if (!progFlash)
+        return;
+    if (progFlashLen > sysVARSTART)
+        sysVARSTART = sysVAREND = sysGOSUBSTART = sysGOSUBEND = MEMORY_SIZE-2;
+    memcpy(&mem[0], progFlash, progFlashLen);
+    sysPROGEND = progFlashLen;
+    sysSTACKSTART = sysSTACKEND = sysPROGEND;
+    progFlash = NULL;
+}
+
 // 指定した行の前の行番号を取得する
 //   引数
 //    lineno
@@ -2878,11 +3825,11 @@ void reset() {
 //    -1 なし 、1以上 行番号 
 //
 int16_t getPrevLineNo(int16_t lineno) {
-    unsigned char *p = &mem[0];              // ポインタに先頭をセット
+    unsigned char *p = PROG_TOP;             // ポインタに先頭をセット
     uint16_t lineNum = -1 ;
     uint16_t prv_lineNum;
 
-    while (p < &mem[sysPROGEND]) {
+    while (p < PROG_END) {
         prv_lineNum = lineNum;               // 前の行番号
         lineNum = *(uint16_t*)(p+2);         // 行番号取得
         if (lineNum >= lineno) {
@@ -2895,10 +3842,10 @@ int16_t getPrevLineNo(int16_t lineno) {
 
 // 指定した行の次の行番号を取得する
 int16_t getNextLineNo(int16_t lineno) {
-    unsigned char *p = &mem[0];              // ポインタに先頭をセット
+    unsigned char *p = PROG_TOP;             // ポインタに先頭をセット
     uint16_t lineNum = -1 ;
 
-    while (p < &mem[sysPROGEND]) {
+    while (p < PROG_END) {
         lineNum = *(uint16_t*)(p+2);         // 行番号取得
         if (lineNum >= lineno) {
             break;
@@ -2906,7 +3853,7 @@ int16_t getNextLineNo(int16_t lineno) {
         p+= *(uint16_t *)p;                  // ポインタを次の行に移動
      }
      p+= *(uint16_t *)p;                     // ポインタを次の行に移動
-     if (p < &mem[sysPROGEND]) {
+     if (p < PROG_END) {
         lineNum = *(uint16_t*)(p+2);         // 行番号取得 
      } else {
         lineNum = -1;
@@ -2917,8 +3864,8 @@ int16_t getNextLineNo(int16_t lineno) {
 // 指定した行のプログラムテキストを取得する
 char* getLineStr(int16_t lineno) {
     uint16_t lineNum = 0;
-    unsigned char *p = &mem[0];              // ポインタに先頭をセット
-    while (p < &mem[sysPROGEND]) {
+    unsigned char *p = PROG_TOP;             // ポインタに先頭をセット
+    while (p < PROG_END) {
         uint16_t tmplineNum = *(uint16_t*)(p+2);  // 行番号取得
         if (tmplineNum == lineno) {
           lineNum = tmplineNum;
@@ -2939,3 +3886,77 @@ char* getLineStr(int16_t lineno) {
     host_outputChar(0,CDEV_MEMORY);             // \0を入れる
     return gettbuf();
 }
+
+// 指定行番号以上の最初の行のポインタを取得する
+//   引数
+//    lineno : 行番号
+//   戻り値
+//    行へのポインタ、NULL:該当行なし
+//
+unsigned char* getLinePtr(uint16_t lineno) {
+    unsigned char *p = findProgLine(lineno);
+    return p < PROG_END ? p : NULL;
+}
+
+// 次の行のポインタを取得する
+//   引数
+//    p : 行へのポインタ
+//   戻り値
+//    次の行へのポインタ、NULL:次の行なし
+//
+unsigned char* getNextLinePtr(unsigned char* p) {
+    p+= *(uint16_t *)p;                      // ポインタを次の行に移動
+    return p < PROG_END ? p : NULL;
+}
+
+// 指定ポインタの行のプログラムテキストを取得する(改行なし)
+//   引数
+//    p : 行へのポインタ
+//   戻り値
+//    行テキスト(テキストバッファ)
+//
+char* getLinePtrStr(unsigned char* p) {
+    cleartbuf();
+    host_outputInt(*(uint16_t*)(p+2),CDEV_MEMORY); // 行番号出力
+    host_outputChar(' ',CDEV_MEMORY);           // 空白出力
+    printTokens(p+4,CDEV_MEMORY);               // 1行分トークン出力
+    host_outputChar(0,CDEV_MEMORY);             // \0を入れる
+    return gettbuf();
+}
+
+// 指定行の直前の1画面分の行の先頭行ポインタを取得する
+//   引数
+//    lineno : 基準行番号(この行番号より前の行が対象)
+//    width  : 画面横文字数
+//    rows   : 画面縦行数
+//   戻り値
+//    先頭行へのポインタ、NULL:前の行なし
+// (メモ)
+//   プログラムの走査は先頭から1回だけ行い、基準行のrows行前の行を追跡する。
+//   各行は1行以上を占めるため、その範囲のみテキスト化して折り返し行数を求め、
+//   画面に収まらない分を先頭側から除く
+//
+unsigned char* getPageTopLinePtr(uint16_t lineno, uint16_t width, uint16_t rows) {
+    unsigned char *p = PROG_TOP;             // ポインタに先頭をセット
+    unsigned char *top = PROG_TOP;           // rows行前の行
+    uint16_t n = 0;                          // 基準行までの行数(rows行まで)
+    uint16_t total = 0;                      // 表示に必要な画面行数
+
+    while (p < PROG_END && *(uint16_t*)(p+2) < lineno) {
+        if (n < rows)
+            n++;
+        else
+            top+= *(uint16_t *)top;
+        p+= *(uint16_t *)p;                  // ポインタを次の行に移動
+    }
+    if (!n)
+        return NULL;
+
+    for (unsigned char *q = top; q < p; q+= *(uint16_t *)q)
+        total+= strlen(getLinePtrStr(q))/width + 1;
+    while (total > rows) {
+        total-= strlen(getLinePtrStr(top))/width + 1;
+        top+= *(uint16_t *)top;
+    }
+    return top;
+}
@@ -70,9 +70,14 @@
 //#define TOKEN_DIR               64
 #define TOKEN_FILES             64
 #define TOKEN_DELETE            65
+#define TOKEN_PASTE             66
+#define TOKEN_COLOR             67
+#define TOKEN_ATTR              68
+#define TOKEN_REMOTE            69
+#define TOKEN_FLASH             70
 
 #define FIRST_IDENT_TOKEN       23
-#define LAST_IDENT_TOKEN        65
+#define LAST_IDENT_TOKEN        70
 
 #define FIRST_NON_ALPHA_TOKEN    8
 #define LAST_NON_ALPHA_TOKEN    22
@@ -105,6 +110,9 @@
 #define ERROR_STR_SUBSCRIPT_OUT_RANGE	    22
 #define ERROR_IN_VAL_INPUT			          23
 #define ERROR_BAD_PARAMETER               24
+#define ERROR_FLASH_WRITE                 25
+#define ERROR_FLASH_FULL                  26
+#define ERROR_FLASH_OLD                   27
 
 #define MAX_IDENT_LEN	   8    // 識別子最大長さ
 #define MAX_NUMBER_LEN	10
@@ -143,5 +151,12 @@ char isExecute();
 void reset();
 int tokenize(unsigned char *input, unsigned char *output, int outputSize);
 int processInput(unsigned char *tokenBuf);
+void progBatchBegin();
+int progBatchAdd(uint16_t lineNumber, unsigned char* tokenPtr, int tokensLength);
+void progBatchCommit();
+void progBatchAbort();
+void progSetFlash(unsigned char *p, uint16_t len);
+void progToRAM();
 void printTokens(unsigned char *p, uint8_t devno = CDEV_SCREEN);
+void printTokensLine(unsigned char *p, uint16_t lineNum);
 #endif
@@ -3,6 +3,8 @@
 
 #include "src/lib/tscreenBase.h"  // コンソール基本
 #include "src/lib/tTermscreen.h"  // シリアルコンソール
+#include "src/lib/ttbasic_error.h" // エラーコード(フラッシュメモリ管理)
+#include "src/lib/ttbasic_numfmt.h" // 数値の文字列変換
 
 int16_t getNextLineNo(int16_t lineno);
 char* getLineStr(int16_t lineno);
@@ -10,6 +12,7 @@ int16_t getPrevLineNo(int16_t lineno);
 void mem_putch(uint8_t c);
 
 #define SIZE_LINE MAXTEXTLEN    // コマンドライン入力バッファサイズ + NULL
+#define SIZE_WORKAREA (TERM_W*TERM_H*2*3/2) // 画面用動的獲得メモリサイズ(文字・属性の2面、表示行数の1.5倍)
 void initScreenEnv();
 tscreenBase* sc;   // 利用デバイススクリーン用ポインタ
 tTermscreen sc1;   // ターミナルスクリーン
@@ -39,7 +42,11 @@ extern EEPROMClass EEPROM;
 // *** フラッシュメモリ管理 ***********
 
 // フラッシュメモリ管理オブジェクト(プログラム保存、システム環境設定を管理）
-tFlashMan FlashMan(FLASH_PAGE_NUM,FLASH_PAGE_SIZE, FLASH_SAVE_NUM, FLASH_PAGE_PAR_PRG); 
+tFlashMan FlashMan(FLASH_PAGE_NUM,FLASH_PAGE_SIZE, FLASH_SAVE_NUM, FLASH_PAGE_PAR_PRG, FLASH_AREA_PAGE_NUM); 
+
+// 画面出力の横取り先(NULL:なし)
+// 設定中はスクリーンへの文字出力をこの関数に渡し、画面操作(消去・カーソル移動・色)と入力は行わない
+static void (*outHook)(const char *str, uint16_t len) = NULL;
 
 char tbuf[SIZE_LINE];          // テキスト表示用バッファ
 int16_t tbuf_pos = 0;
@@ -62,6 +69,11 @@ char* gettbuf() {
   return tbuf;
 }
 
+// メモリ書き込み文字数の取得
+int16_t gettbufLen() {
+  return tbuf_pos;
+}
+
 // 文字入出力
 #define c_getch()       sc->get_ch()
 #define c_kbhit( )      sc->isKeyIn()
@@ -71,16 +83,34 @@ char* gettbuf() {
 //  c     : 出力文字
 //  devno : デバイス番号
 void c_putch(uint8_t c, uint8_t devno=CDEV_SCREEN) {
-  if (devno == CDEV_SCREEN )
+  if (devno == CDEV_SCREEN && outHook)
+    outHook((const char*)&c, 1); // 横取り先への出力
+  else if (devno == CDEV_SCREEN )
     sc->putch(c); // メインスクリーンへの文字出力
   else if (devno == CDEV_MEMORY)
    mem_putch(c); // メモリーへの文字列出力
 } 
 
+// 指定デバイスへの文字列の出力
+//  str   : 出力文字列
+//  len   : 文字列長
+//  devno : デバイス番号
+void c_write(const char* str, uint16_t len, uint8_t devno=CDEV_SCREEN) {
+  if (devno == CDEV_SCREEN && outHook)
+    outHook(str, len);                   // 横取り先への出力
+  else if (devno == CDEV_SCREEN )
+    sc->write((const uint8_t*)str, len); // メインスクリーンへの文字列出力
+  else if (devno == CDEV_MEMORY)
+    while (len--)
+      mem_putch(*str++);                 // メモリーへの文字列出力
+}
+
 // 改行
 //  devno : デバイス番号
 void c_newLine(uint8_t  devno=CDEV_SCREEN) {
- if (devno== CDEV_SCREEN )
+ if (devno == CDEV_SCREEN && outHook)
+   outHook("\n", 1);     // 横取り先への出力
+ else if (devno== CDEV_SCREEN )
    sc->newLine();        // メインスクリーンへの文字出力
   else if (devno == CDEV_MEMORY )
     mem_putch('\n');     // メモリーへの文字列出力   
@@ -119,14 +149,16 @@ void host_init(int buzzerPin) {
 #endif
 //  initTimer();
 
-  workarea = (uint8_t*)malloc(5760); // SCREEN0で128x45まで
+  workarea = (uint8_t*)malloc(SIZE_WORKAREA);
   sc = &sc1;
-  ((tTermscreen*)sc)->init(TERM_W,TERM_H,SIZE_LINE, workarea); // スクリーン初期設定  
+  ((tTermscreen*)sc)->init(TERM_W,TERM_H,SIZE_LINE, workarea, SIZE_WORKAREA); // スクリーン初期設定(余裕分はスクロールに利用)
   sc->Serial_mode(serialMode, defbaud); // デバイススクリーンのシリアル出力の設定
+  FlashMan.scanPrgArea();               // プログラム保存領域の走査
 }
 
 // スリープ
 void host_sleep(long ms) {
+  sc->flush();
   delay(ms);
 }
 
@@ -174,6 +206,8 @@ void host_startupTone() {
 
 // スクリーンクリア
 void host_cls() {
+    if (outHook)
+      return;
     c_cls();
     host_moveCursor(0,0);
 //  curY = 0;
@@ -181,24 +215,39 @@ void host_cls() {
 
 // カーソル移動
 void host_moveCursor(int x, int y) {
+ if (outHook)
+   return;
  sc->locate((uint16_t)x, (uint16_t)y);
 }
 
+// 文字色の設定(以降に出力する文字に適用、再表示でも保持される)
+// 引数
+//  fc : 文字色 0:黒 1:赤 2:緑 3:茶 4:青 5:マゼンタ 6:シアン 7:標準 8:黄
+//  bc : 背景色 0:黒 1:赤 2:緑 3:茶 4:青 5:マゼンタ 6:シアン 7:白 8:黄
+void host_setColor(int fc, int bc) {
+  if (outHook)
+    return;
+  sc->setColor((uint16_t)fc, (uint16_t)bc);
+}
+
+// 文字属性の設定(以降に出力する文字に適用、再表示でも保持される)
+// 引数
+//  attr : 0:標準 1:下線 2:反転 3:点滅 4:太字
+void host_setAttr(int attr) {
+  if (outHook)
+    return;
+  sc->setAttr((uint16_t)attr);
+}
+
 // 画面バッファに文字列を出力
 void host_outputString(char *str, uint8_t devno) {
-    while (*str) {
-        c_putch(*str,devno);
-        str++;
-    }
+    c_write(str, strlen(str), devno);
 }
 
 // フラシュメモリ上の文字列を出力
+// (STM32ではフラッシュメモリ上の文字列も直接参照できる)
 void host_outputProgMemString(const char *p, uint8_t devno) {
-    while (1) {
-      unsigned char c = *p++;
-      if (c == 0) break;
-      host_outputChar(c,devno);
-    }
+    c_write(p, strlen(p), devno);
 }
 
 // 文字を出力
@@ -209,52 +258,10 @@ void host_outputChar(char c, uint8_t devno) {
 // 数値を出力
 int host_outputInt(long num, uint8_t devno) {
   // returns len
-  long i = num, xx = 1;
-  int c = 0;
-  do {
-    c++;
-    xx *= 10;
-    i /= 10;
-  } 
-  while (i);
-
-  for (int i=0; i<c; i++) {
-    xx /= 10;
-    char digit = ((num/xx) % 10) + '0';
-    host_outputChar(digit,devno);
-  }
-  return c;
-}
-
-// フロート型を文字列変換
-char *host_floatToStr(float f, char *buf) {
-  // floats have approx 7 sig figs
-  float a = fabs(f);
-  if (f == 0.0f) {
-    buf[0] = '0'; 
-    buf[1] = 0;
-  } else if (a<0.0001 || a>1000000) {
-    // this will output -1.123456E99 = 13 characters max including trailing nul
-#if defined(__AVR__) 
-   dtostre(f, buf, 6, 0);
-#else
-   sprintf(buf, "%6.2e", f);
-#endif
-  } else {
-    int decPos = 7 - (int)(floor(log10(a))+1.0f);
-    dtostrf(f, 1, decPos, buf);
-    if (decPos) {
-      // remove trailing 0s
-      char *p = buf;
-      while (*p) p++;
-      p--;
-      while (*p == '0') {
-          *p-- = 0;
-      }
-      if (*p == '.') *p = 0;
-    }   
-  }
-  return buf;
+  char buf[12];
+  int len = host_intToStr(num, buf);
+  c_write(buf, len, devno);
+  return len;
 }
 
 // フロート型数値出力
@@ -270,6 +277,9 @@ void host_newLine(uint8_t  devno) {
 
 // 行入力
 uint16_t host_input() {
+    if (outHook)
+      return 0;        // 画面出力の横取り中は入力不可(中断扱い)
+    sc->flush();
     uint16_t rc = sc->editLine();
      sc->show_curs(true);
     return rc; 
@@ -285,6 +295,7 @@ char *host_readLine() {
     uint8_t rc;        // 関数戻り値受け取り用
     char* textline;    // 入力行
 
+    sc->flush();
     while (1) { //無限ループ
         rc = sc->edit();  // エディタ入力
         if (rc) {
@@ -314,34 +325,125 @@ char *host_readLine() {
     return textline;
 }
 
-uint8_t prevPressKey = 0;   // 直前入力キーの値(INKEY()、[ESC]中断キー競合防止用)
-
+// キー入力(先行入力バッファから取得、入力なしの場合は0)
+// 未処理の中断キーがある場合は、中断を優先するため取得しない
 char host_getKey() {
-  int16_t rc = 0;
-  
-  if (prevPressKey) {
-    // 一時バッファに入力済キーがあればそれを使う
-    rc = prevPressKey;
-    prevPressKey = 0;
-  } else if (c_kbhit( )) {
-    // キー入力
-    rc = c_getch();
-  }
-  return rc;  
+  if (sc->isBreak() || outHook)
+    return 0;
+  return c_kbhit();
 }
 
 // 中断キー入力チェック
+// 中断キーの検出は受信側で行い、ここでは検出フラグのみを参照する
 bool host_ESCPressed() {
-    uint8_t c = c_kbhit();
-    if (c) {
-        if (c == PS2_CTRL_C || c==PS2_ESC ) { // 読み込んでもし[ESC],［CTRL_C］キーだったら
-            prevPressKey = 0;
-            return true;
+    if (!sc->isBreak())
+        return false;
+    sc->clearBreak();
+    return true;
+}
+
+// テキスト1行の受信(エコーなし、編集なし)
+//  - [CR]、[LF]を行の終わりとする([CR][LF]の場合は空行が続く)
+//  - [CTRL-Z]、[CTRL-D]を受信したら終了する(受信途中の行は返してから終了)
+//  - [CTRL-C]を受信したら中断する(受信途中の行は破棄)
+// 引数
+//  buf  : 受信バッファ
+//  size : 受信バッファサイズ
+// 戻り値
+//  行の長さ(size以上の場合は溢れた分を破棄)、-1:終了 -2:中断
+//
+int16_t host_readRawLine(char *buf, int16_t size) {
+    static uint8_t flgEnd = 0;   // 行の途中で終了キーを受信した
+    uint8_t tmp[32];             // 溢れた分の受信用
+    uint8_t *p;
+    int16_t len = 0;
+    uint16_t n;
+    uint8_t c;
+
+    if (flgEnd) {
+        flgEnd = 0;
+        return -1;
+    }
+    for (;;) {
+        // 制御コードまでをまとめて受信(制御コードは末尾にのみ入る)
+        if (len < size - 1) {
+            p = (uint8_t*)&buf[len];
+            n = sc->read(p, size - 1 - len);
         } else {
-            prevPressKey = c;        
+            p = tmp;
+            n = sc->read(tmp, sizeof(tmp));
         }
-     }
-     return false;
+        c = p[n-1];
+        if (c == '\r' || c == '\n') {
+            len += n-1;
+            break;
+        }
+        if (c == KEY_CTRL_C)                   // [CTRL-C]
+            return -2;
+        if (c == 0x1A || c == KEY_CTRL_D) {    // [CTRL-Z]、[CTRL-D]
+            len += n-1;
+            if (!len)
+                return -1;
+            flgEnd = 1;
+            break;
+        }
+        len += n;
+    }
+    buf[len < size ? len : size - 1] = 0;
+    return len;
+}
+
+// 受信フロー制御(XON/XOFF)
+//  flg : true 受信再開(XON) false 受信停止(XOFF)
+void host_flowCtrl(uint8_t flg) {
+    sc->flowCtrl(flg);
+}
+
+// 出力の吐き出し
+void host_flush() {
+    sc->flush();
+}
+
+// 送信統計の取得
+//  queued : 送信要求バイト数(累計)
+//  stalls : 送信バッファ満杯による送信待ち回数(累計)
+//  peak   : 送信バッファ滞留バイト数の最大値
+void host_getTxStat(uint32_t* queued, uint32_t* stalls, uint16_t* peak) {
+    sc->getTxStat(queued, stalls, peak);
+}
+
+// 受信統計の取得
+//  bytes    : 受信バイト数(累計)
+//  overflow : 受信バッファ満杯で取り込みを保留した回数(累計)
+//  peak     : 受信バッファ滞留バイト数の最大値
+void host_getRxStat(uint32_t* bytes, uint32_t* overflow, uint16_t* peak) {
+    sc->getRxStat(bytes, overflow, peak);
+}
+
+// バイナリデータの受信(エコーなし、編集なし)
+// 指定バイト数を受信するまで待つ
+//  buf : 受信バッファ
+//  n   : 受信バイト数
+void host_readBytes(uint8_t *buf, uint16_t n) {
+    uint16_t len;
+    while (n) {
+        len = sc->read(buf, n);
+        buf += len;
+        n -= len;
+    }
+}
+
+// 表示を介さないデータの送信
+//  buf : 送信データ
+//  len : バイト数
+void host_writeRaw(const uint8_t *buf, uint16_t len) {
+    sc->writeRaw(buf, len);
+}
+
+// 画面出力の横取り先の設定
+//  hook : スクリーンへの文字出力を渡す関数、NULL:横取りの解除
+void host_setOutputHook(void (*hook)(const char *str, uint16_t len)) {
+    outHook = hook;
 }
 
 // 空き領域の表示
@@ -352,21 +454,34 @@ void host_outputFreeMem(unsigned int val) {
   host_outputProgMemString(bytesFreeStr,CDEV_SCREEN);      
 }
 
-void host_saveProgram(bool autoexec,int16_t flleNo) {
-
-  // プログラムsysPROGENDの保存
-  mem[MEMORY_SIZE-2] = sysPROGEND & 0xFF;
-  mem[MEMORY_SIZE-1] = (sysPROGEND >> 8) & 0xFF;
-  
-  FlashMan.saveProgram(flleNo, mem);  
+// プログラムの保存
+// 引数
+//  autoexec : 自動起動指定
+//  flleNo   : 保存番号
+// 戻り値
+//  0:正常終了 ERROR_FLASH_FULL:空き領域不足 ERROR_FLASH_OLD:旧形式の保存領域 ERROR_FLASH_WRITE:書込み失敗
+// プログラム長(sysPROGEND)分のみをフラッシュメモリに書き込む(FLASH_COMPRESS=1の場合は圧縮)
+int host_saveProgram(bool autoexec,int16_t flleNo) {
+  switch (FlashMan.saveProgram(flleNo, mem, sysPROGEND, FLASH_COMPRESS)) {
+    case 0:              return 0;
+    case ERR_FLASH_FULL: return ERROR_FLASH_FULL;
+    case ERR_FLASH_OLD:  return ERROR_FLASH_OLD;
+    default:             return ERROR_FLASH_WRITE;
+  }
 }
 
+// プログラムのロード
+// 引数
+//  flleNo   : 保存番号
+// mem[]には複写せず、フラッシュメモリ上の格納位置から直接実行する(編集時にmem[]に複写)
+// 圧縮して保存したプログラムはmem[]に展開する
 void host_loadProgram(int16_t flleNo) {
-  FlashMan.loadProgram(flleNo, mem);
-
-  // プログラムsysPROGENDのセット
-  sysPROGEND = mem[MEMORY_SIZE-2] | (mem[MEMORY_SIZE-1] << 8);
-
+  uint8_t* p = FlashMan.getPrgAddress(flleNo);
+  uint16_t len;
+  if (p)
+    progSetFlash(p, FlashMan.getPrgSize(flleNo));
+  else if (!FlashMan.loadProgram(flleNo, mem, &len))
+    sysPROGEND = len;  // プログラムsysPROGENDのセット
 }
 
 void host_show_curs(uint8_t flg) {
@@ -27,8 +27,11 @@ extern tFlashMan FlashMan;
 
 #define FLASH_PAGE_NUM         128     // 全ページ数
 #define FLASH_PAGE_SIZE        1024    // ページ内バイト数
-#define FLASH_PAGE_PAR_PRG     4       // 1プログラム当たりの利用ページ数
-#define FLASH_SAVE_NUM         6       // プログラム保存可能数
+#define FLASH_PAGE_PAR_PRG     4       // 1プログラム当たりの最大ページ数
+#define FLASH_SAVE_NUM         16      // プログラム保存可能数(プログラム番号 0～15)
+#define FLASH_AREA_PAGE_NUM    24      // プログラム保存領域のページ数
+#define FLASH_COMPRESS         0       // SAVE時のプログラムのLZ圧縮 0:しない 1:する
+                                       // (圧縮したプログラムはLOAD時にRAMに展開し、フラッシュメモリ上では実行しない)
 
 // 入出力キャラクターデバイス
 #define CDEV_SCREEN   0  // メインスクリーン
@@ -38,6 +41,7 @@ extern tFlashMan FlashMan;
 #define CDEV_SDFILES  4  // ファイル
 
 char * gettbuf();
+int16_t gettbufLen();
 void cleartbuf();
 void c_putch(uint8_t c, uint8_t devno);
 void host_init(int buzzerPin);
@@ -50,20 +54,31 @@ void host_pinMode(int pin, WiringPinMode mode);
 void host_cls();
 void host_showBuffer();
 void host_moveCursor(int x, int y);
+void host_setColor(int fc, int bc);
+void host_setAttr(int attr);
 void host_outputString(char *str, uint8_t devno);
 void host_outputProgMemString(const char *str, uint8_t devno);
 void host_outputChar(char c, uint8_t devno);
 void host_outputFloat(float f,uint8_t  devno);
 char *host_floatToStr(float f, char *buf);
 int host_outputInt(long val, uint8_t devno);
+int host_intToStr(long num, char *buf);
 void host_newLine(uint8_t devno);
 char *host_readLine();
 uint16_t host_input();
 char *host_getInputText();
 char host_getKey();
 bool host_ESCPressed();
+int16_t host_readRawLine(char *buf, int16_t size);
+void host_flowCtrl(uint8_t flg);
+void host_flush();
+void host_getTxStat(uint32_t* queued, uint32_t* stalls, uint16_t* peak);
+void host_getRxStat(uint32_t* bytes, uint32_t* overflow, uint16_t* peak);
+void host_readBytes(uint8_t *buf, uint16_t n);
+void host_writeRaw(const uint8_t *buf, uint16_t len);
+void host_setOutputHook(void (*hook)(const char *str, uint16_t len));
 void host_outputFreeMem(unsigned int val);
 
-void host_saveProgram(bool autoexec, int16_t flleNo);
+int host_saveProgram(bool autoexec, int16_t flleNo);
 void host_loadProgram(int16_t flleNo);
 void host_show_curs(uint8_t flg);
@@ -18,6 +18,12 @@
 // 修正 2018/01/30 キーコードの変更（全角文字シフトJIS対応のため）
 // 修正 2018/02/14 Arduino(AVR)用SRAM利用消費軽減対応
 // 修正 2018/05/07 Arduino(AVR)以外の環境への対応‘
+// 修正 2026/10/18 スクロール領域の常時設定、カーソル移動の遅延出力、端末の自動改行の利用
+// 修正 2026/10/18 表示内容の写し(シャドウバッファ)による差分行表示 mcurses_updline()の追加
+// 修正 2026/10/18 カーソル移動を出力バイト数が最小となる方法(CR,LF,BS,TAB,相対移動,文字の再出力)で行う
+// 修正 2026/10/18 文字列の一括出力 addnstr()、一括出力用フック関数の追加
+// 修正 2026/10/18 キー入力のエスケープシーケンスを1バイトずつ状態遷移で復号(文字列比較の廃止)
+// 修正 2026/10/18 属性の差分のみを出力するattrset()、シャドウバッファへの属性面の追加、mcurses_updline()の属性対応
 //
 
 #include <stdio.h>
@@ -57,11 +63,36 @@
 #define SEQ_RESET_SCRREG                        PSTR("\033[r")                  // reset scrolling region
 #define SEQ_LOAD_G1                             PSTR("\033)0")                  // load G1 character set
 #define SEQ_CURSOR_VIS                          PSTR("\033[?25")                // set cursor visible/not visible
+#define SEQ_AUTOWRAP                            PSTR("\033[?7h")                // enable autowrap
+#define SEQ_CURSOR_UP                           'A'                             // cursor up n lines, CSI n A
+#define SEQ_CURSOR_DOWN                         'B'                             // cursor down n lines, CSI n B
+#define SEQ_CURSOR_FORWARD                      'C'                             // cursor forward n columns, CSI n C
+#define SEQ_CURSOR_BACK                         'D'                             // cursor back n columns, CSI n D
+
+#define MCURSES_TABSIZE                         8                               // default tab stops of the terminal
+
+#define MCURSES_UPD_GAP                         6                               // mcurses_updline(): unchanged cells re-sent rather than moving the cursor
+#define MCURSES_UPD_EL                          4                               // mcurses_updline(): min. number of changed blank cells to use EL
+#define MCURSES_CELL(c)                         (((c) < ' ') ? ' ' : (c))         // shadow cell of a screen byte, 0 and control codes are shown as blank
+#define MCURSES_SHADOW_ATTR(line)               ((line) + mcurses_lines * mcurses_cols) // attributes of a shadow line
+#define MCURSES_SJIS1(c)                        ((((c) >= 0x81) && ((c) <= 0x9f)) || (((c) >= 0xe0) && ((c) <= 0xfc)))  // Shift-JIS 1st byte
 
 static uint_fast8_t                             mcurses_scrl_start = 0;         // start of scrolling region, default is 0
 static uint_fast8_t                             mcurses_scrl_end = LINES - 1;   // end of scrolling region, default is last line
 static uint_fast8_t                             mcurses_nodelay;                // nodelay flag
+static uint_fast8_t                             mcurses_lines = LINES;          // number of lines (resizeterm())
+static uint_fast8_t                             mcurses_cols = COLS;            // number of columns (resizeterm())
+static uint_fast8_t                             mcurses_phy_scrl_start = 0xff;  // scrolling region set on the terminal, 0xff = unknown
+static uint_fast8_t                             mcurses_phy_scrl_end = 0xff;
+static uint_fast8_t                             mcurses_phy_y = 0xff;           // cursor position on the terminal, 0xff = unknown
+static uint_fast8_t                             mcurses_phy_x = 0xff;           // mcurses_cols = wrap pending after writing the last column
 static uint_fast8_t                             mcurses_halfdelay;              // halfdelay value, in tenths of a second
+static uint8_t *                                mcurses_shadow = 0;             // what the terminal shows: characters (lines * cols), then their
+                                                                                // attributes (lines * cols), 0 = no shadow, cell 0 = unknown
+static uint_fast8_t                             mcurses_shadow_top = 0;         // ring offset: buffer line of screen line 0
+static uint_fast8_t                             mcurses_insert_mode = FALSE;    // terminal is in insert mode
+static uint_fast16_t                            mcurses_attr = 0xffff;          // current attributes, 0xffff = not set yet
+static uint_fast8_t                             mcurses_attr_cell = 0xff;       // current attributes as cell attribute (mcurses_attr8())
 
 uint_fast8_t                                    mcurses_is_up = 0;              // flag: mcurses is up
 uint_fast8_t                                    mcurses_cury = 0xff;            // current y position of cursor, public (getyx())
@@ -71,6 +102,7 @@ static void                                     mcurses_puts_P (const char *);
 
 char (*FunctionPointer_getchar)(void);
 void  (*FunctionPointer_putchar)(uint_fast8_t ch);
+void  (*FunctionPointer_write)(const uint8_t * buf, uint_fast8_t len);
 
 void setFunction_getchar(char (*functionPoitner)(void))
 {
@@ -82,9 +114,14 @@ void setFunction_putchar(void (*functionPoitner)(uint8_t ch))
 	FunctionPointer_putchar = functionPoitner;
 }
 
-static uint_fast8_t mcurses_phyio_init (void)
+void setFunction_write(void (*functionPoitner)(const uint8_t * buf, uint_fast8_t len))
 {
+	FunctionPointer_write = functionPoitner;
+}
 
+static uint_fast8_t mcurses_phyio_init (void)
+{
+    return TRUE;                                                                // nothing to do, the serial port is set up by the caller
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -101,6 +138,12 @@ static void mcurses_phyio_putc (uint_fast8_t ch)
 	if(FunctionPointer_putchar!=0)	FunctionPointer_putchar(ch);
 }
 
+static void mcurses_phyio_write (const uint8_t * buf, uint_fast8_t len)
+{
+	if(FunctionPointer_write!=0)	FunctionPointer_write(buf, len);
+	else while (len--)	mcurses_phyio_putc(*buf++);
+}
+
 static uint_fast8_t mcurses_phyio_getc (void)
 {
 	if(FunctionPointer_getchar!=0)	return FunctionPointer_getchar();
@@ -187,6 +230,92 @@ mcurses_puti (uint_fast8_t i)
     mcurses_putc (i + '0');
 }
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: get line y of the shadow buffer
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint8_t *
+mcurses_shadow_line (uint_fast8_t y)
+{
+    uint_fast16_t   l = y + mcurses_shadow_top;
+
+    if (l >= mcurses_lines)
+    {
+        l -= mcurses_lines;
+    }
+    return mcurses_shadow + l * mcurses_cols;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: scroll lines top..bottom of the shadow buffer one line up or down, the new line is blank
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+mcurses_shadow_scroll (uint_fast8_t top, uint_fast8_t bottom, uint_fast8_t up)
+{
+    uint_fast8_t    y;
+
+    if (! mcurses_shadow || top > bottom || bottom >= mcurses_lines)
+    {
+        return;
+    }
+
+    if (top == 0 && bottom == mcurses_lines - 1)                                // whole screen: rotate the ring
+    {
+        if (up)
+        {
+            mcurses_shadow_top = (mcurses_shadow_top + 1 < mcurses_lines) ? mcurses_shadow_top + 1 : 0;
+        }
+        else
+        {
+            mcurses_shadow_top = mcurses_shadow_top ? mcurses_shadow_top - 1 : mcurses_lines - 1;
+        }
+    }
+    else if (up)
+    {
+        for (y = top; y < bottom; y++)
+        {
+            memcpy (mcurses_shadow_line (y), mcurses_shadow_line (y + 1), mcurses_cols);
+            memcpy (MCURSES_SHADOW_ATTR (mcurses_shadow_line (y)), MCURSES_SHADOW_ATTR (mcurses_shadow_line (y + 1)), mcurses_cols);
+        }
+    }
+    else
+    {
+        for (y = bottom; y > top; y--)
+        {
+            memcpy (mcurses_shadow_line (y), mcurses_shadow_line (y - 1), mcurses_cols);
+            memcpy (MCURSES_SHADOW_ATTR (mcurses_shadow_line (y)), MCURSES_SHADOW_ATTR (mcurses_shadow_line (y - 1)), mcurses_cols);
+        }
+    }
+    memset (mcurses_shadow_line (up ? bottom : top), ' ', mcurses_cols);
+    memset (MCURSES_SHADOW_ATTR (mcurses_shadow_line (up ? bottom : top)), mcurses_attr_cell, mcurses_cols);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: blank the shadow buffer from (y, x) to the end of line y, or to the bottom of the screen
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+mcurses_shadow_clear (uint_fast8_t y, uint_fast8_t x, uint_fast8_t tobot)
+{
+    if (! mcurses_shadow || y >= mcurses_lines)
+    {
+        return;
+    }
+
+    if (x < mcurses_cols)
+    {
+        memset (mcurses_shadow_line (y) + x, ' ', mcurses_cols - x);
+        memset (MCURSES_SHADOW_ATTR (mcurses_shadow_line (y)) + x, mcurses_attr_cell, mcurses_cols - x);
+    }
+
+    while (tobot && ++y < mcurses_lines)
+    {
+        memset (mcurses_shadow_line (y), ' ', mcurses_cols);
+        memset (MCURSES_SHADOW_ATTR (mcurses_shadow_line (y)), mcurses_attr_cell, mcurses_cols);
+    }
+}
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  * INTERN: addch or insch a character
  *---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -198,26 +327,76 @@ static void
 mcurses_addch_or_insch (uint_fast8_t ch, uint_fast8_t insert)
 {
     static uint_fast8_t  charset = 0xff;
-    static uint_fast8_t  insert_mode = FALSE;
+
+    if (ch == '\007')                                                           // bell: no cursor movement
+    {
+        mcurses_putc (ch);
+        return;
+    }
 
     if (insert)
     {
-        if (! insert_mode)
+        if (! mcurses_insert_mode)
         {
             mcurses_puts_P (SEQ_INSERT_MODE);
-            insert_mode = TRUE;
+            mcurses_insert_mode = TRUE;
         }
     }
     else
     {
-        if (insert_mode)
+        if (mcurses_insert_mode)
         {
             mcurses_puts_P (SEQ_REPLACE_MODE);
-            insert_mode = FALSE;
+            mcurses_insert_mode = FALSE;
+
+            if (mcurses_phy_x == mcurses_cols)
+            {
+                mcurses_phy_y = mcurses_phy_x = 0xff;                           // do not rely on a pending wrap across mode changes
+            }
         }
     }
 
+    if (! mcurses_insert_mode && mcurses_phy_x == mcurses_cols && mcurses_cury == mcurses_phy_y + 1 && mcurses_curx == 0 &&
+        mcurses_phy_scrl_start == mcurses_scrl_start && mcurses_phy_scrl_end == mcurses_scrl_end &&
+        mcurses_phy_y != mcurses_scrl_end && mcurses_cury < mcurses_lines)
+    {                                                                           // wrap pending: the terminal moves to the next line itself
+        mcurses_phy_y = mcurses_cury;
+        mcurses_phy_x = 0;
+    }
+    else
+    {
+        mcurses_sync ();
+    }
+
     mcurses_putc (ch);
+
+    if (ch < ' ')
+    {
+        mcurses_phy_y = mcurses_phy_x = 0xff;                                   // control character: position unknown
+
+        if (mcurses_shadow)
+        {
+            memset (mcurses_shadow, 0, 2 * mcurses_lines * mcurses_cols);       // may start a sequence: contents unknown
+        }
+    }
+    else
+    {
+        mcurses_phy_x++;
+
+        if (mcurses_shadow && mcurses_cury < mcurses_lines && mcurses_curx < mcurses_cols)
+        {
+            uint8_t * line = mcurses_shadow_line (mcurses_cury);
+            uint8_t * attrs = MCURSES_SHADOW_ATTR (line);
+
+            if (mcurses_insert_mode)
+            {
+                memmove (line + mcurses_curx + 1, line + mcurses_curx, mcurses_cols - mcurses_curx - 1);
+                memmove (attrs + mcurses_curx + 1, attrs + mcurses_curx, mcurses_cols - mcurses_curx - 1);
+            }
+            line[mcurses_curx] = ch;
+            attrs[mcurses_curx] = mcurses_attr_cell;
+        }
+    }
     mcurses_curx++;
 }
 
@@ -243,214 +422,763 @@ mysetscrreg (uint_fast8_t top, uint_fast8_t bottom)
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * move cursor (raw)
+ * INTERN: set scrolling region on the terminal, only if it has changed
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 static void
-mymove (uint_fast8_t y, uint_fast8_t x)
+mcurses_phy_setscrreg (uint_fast8_t top, uint_fast8_t bottom)
 {
-    mcurses_puts_P (SEQ_CSI);
-    mcurses_puti (y + 1);
-    mcurses_putc (';');
-    mcurses_puti (x + 1);
-    mcurses_putc ('H');
+    if (mcurses_phy_scrl_start != top || mcurses_phy_scrl_end != bottom)
+    {
+        mysetscrreg (top, bottom);
+        mcurses_phy_scrl_start = top;
+        mcurses_phy_scrl_end = bottom;
+        mcurses_phy_y = mcurses_phy_x = 0xff;                                   // DECSTBM homes the cursor
+    }
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: initialize
+ * INTERN: number of digits of a 1..3 digit number
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast8_t
-initscr (void)
+static uint_fast8_t
+mcurses_digits (uint_fast8_t i)
 {
-    uint_fast8_t rtc;
-
-    if (mcurses_phyio_init ())
-    {
-        mcurses_puts_P (SEQ_LOAD_G1);                                               // load graphic charset into G1
-        attrset (A_NORMAL);
-        clear ();
-        move (0, 0);
-        mcurses_is_up = 1;
-        rtc = OK;
-    }
-    else
-    {
-        rtc = ERR;
-    }
-    return rtc;
+    return (i >= 100) ? 3 : (i >= 10) ? 2 : 1;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: add character
+ * INTERN: cost of CSI n <cmd>, n = 1 is omitted
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-addch (uint_fast8_t ch)
+static uint_fast8_t
+mcurses_csi_n_cost (uint_fast8_t n)
 {
-    mcurses_addch_or_insch (ch, FALSE);
+    return (n == 1) ? 3 : 3 + mcurses_digits (n);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: add string
+ * INTERN: put CSI n <cmd> (raw), n = 1 is omitted
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-addstr (const char * str)
+static void
+mcurses_csi_n (uint_fast8_t n, uint_fast8_t cmd)
 {
-    while (*str)
+    mcurses_puts_P (SEQ_CSI);
+
+    if (n != 1)
     {
-        mcurses_addch_or_insch (*str++, FALSE);
+        mcurses_puti (n);
     }
+    mcurses_putc (cmd);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: add string
+ * move cursor (raw), the column is omitted for column 0, both for the home position
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-addstr_P (const char * str)
+static uint_fast8_t
+mymove_cost (uint_fast8_t y, uint_fast8_t x)
 {
-    uint_fast8_t ch;
-
-    while ((ch = pgm_read_byte(str)) != '\0')
+    if (x == 0)
     {
-        mcurses_addch_or_insch (ch, FALSE);
-        str++;
+        return (y == 0) ? 3 : 3 + mcurses_digits (y + 1);
     }
+    return 4 + mcurses_digits (y + 1) + mcurses_digits (x + 1);
 }
 
+static void
+mymove (uint_fast8_t y, uint_fast8_t x)
+{
+    mcurses_puts_P (SEQ_CSI);
+
+    if (y != 0 || x != 0)
+    {
+        mcurses_puti (y + 1);
+    }
+
+    if (x != 0)
+    {
+        mcurses_putc (';');
+        mcurses_puti (x + 1);
+    }
+    mcurses_putc ('H');
+}
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: set attribute(s)
+ * INTERN: vertical relative move from line y0 to line y, returns cost, output only if emit is set
+ *         0xff: not possible, the cursor would stop at a margin of the scrolling region (or it is unknown)
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-attrset (uint_fast16_t attr)
+static uint_fast8_t
+mcurses_vmove (uint_fast8_t y0, uint_fast8_t y, uint_fast8_t emit)
 {
-    static uint_fast8_t mcurses_attr = 0xff;                    // current attributes
-    uint_fast8_t        idx;
+    uint_fast8_t    n;
 
-    if (attr != mcurses_attr)
+    if (y == y0)
     {
-        mcurses_puts_P (SEQ_ATTRSET);
+        return 0;
+    }
 
-        idx = (attr & F_COLOR) >> 8;
+    if (mcurses_phy_scrl_start == 0xff)
+    {
+        return 0xff;
+    }
 
-        if (idx >= 1 && idx <= 8)
+    if (y > y0)
+    {
+        if (y0 <= mcurses_phy_scrl_end && y > mcurses_phy_scrl_end)
         {
-            mcurses_puts_P (SEQ_ATTRSET_FCOLOR);
-            mcurses_putc (idx - 1 + '0');
+            return 0xff;                                                        // CUD stops, LF scrolls at the bottom margin
         }
 
-        idx = (attr & B_COLOR) >> 12;
+        n = y - y0;
 
-        if (idx >= 1 && idx <= 8)
+        if (n <= mcurses_csi_n_cost (n))                                        // LF: one byte per line
         {
-            mcurses_puts_P (SEQ_ATTRSET_BCOLOR);
-            mcurses_putc (idx - 1 + '0');
+            while (emit && n--)
+            {
+                mcurses_putc ('\n');
+            }
+            return y - y0;
         }
 
-        if (attr & A_REVERSE)
+        if (emit)
         {
-            mcurses_puts_P (SEQ_ATTRSET_REVERSE);
-        }
-        if (attr & A_UNDERLINE)
-        {
-            mcurses_puts_P (SEQ_ATTRSET_UNDERLINE);
-        }
-        if (attr & A_BLINK)
-        {
-            mcurses_puts_P (SEQ_ATTRSET_BLINK);
-        }
-        if (attr & A_BOLD)
-        {
-            mcurses_puts_P (SEQ_ATTRSET_BOLD);
-        }
-        if (attr & A_DIM)
-        {
-            mcurses_puts_P (SEQ_ATTRSET_DIM);
+            mcurses_csi_n (n, SEQ_CURSOR_DOWN);
         }
-        mcurses_putc ('m');
-        mcurses_attr = attr;
+        return mcurses_csi_n_cost (n);
     }
-}
 
-/*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: move cursor
- *---------------------------------------------------------------------------------------------------------------------------------------------------
- */
-void
-move (uint_fast8_t y, uint_fast8_t x)
-{
-    if (mcurses_cury != y || mcurses_curx != x)
+    if (y0 >= mcurses_phy_scrl_start && y < mcurses_phy_scrl_start)
     {
-        mcurses_cury = y;
-        mcurses_curx = x;
-        mymove (y, x);
+        return 0xff;                                                            // CUU stops at the top margin
+    }
+
+    n = y0 - y;
+
+    if (emit)
+    {
+        mcurses_csi_n (n, SEQ_CURSOR_UP);
     }
+    return mcurses_csi_n_cost (n);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: delete line
+ * INTERN: check if the characters in line y, columns x0..x-1 can be sent again to move the cursor forward:
+ *         they have to be known (shadow), plain ASCII and shown with the current attributes, and insert mode must be off
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-deleteln (void)
+static uint_fast8_t
+mcurses_can_reemit (uint_fast8_t y, uint_fast8_t x0, uint_fast8_t x)
 {
-    mysetscrreg (mcurses_scrl_start, mcurses_scrl_end);                         // set scrolling region
-    mymove (mcurses_cury, 0);                                                   // goto to current line
-    mcurses_puts_P (SEQ_DELETELINE);                                            // delete line
-    mysetscrreg (0, 0);                                                         // reset scrolling region
-    mymove (mcurses_cury, mcurses_curx);                                        // restore position
+    uint8_t *   line;
+    uint8_t *   attrs;
+
+    if (! mcurses_shadow || mcurses_insert_mode || mcurses_attr_cell == 0xff || y >= mcurses_lines)
+    {
+        return FALSE;
+    }
+
+    line = mcurses_shadow_line (y);
+    attrs = MCURSES_SHADOW_ATTR (line);
+
+    while (x0 < x)
+    {
+        if (line[x0] < ' ' || line[x0] >= 0x7f || attrs[x0] != mcurses_attr_cell)
+        {
+            return FALSE;
+        }
+        x0++;
+    }
+    return TRUE;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: insert line
+ * INTERN: cost of moving forward in line y from column x0 to column x by re-sending the characters or CUF
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-insertln (void)
+static uint_fast8_t
+mcurses_fwd_cost (uint_fast8_t y, uint_fast8_t x0, uint_fast8_t x)
 {
-    mysetscrreg (mcurses_cury, mcurses_scrl_end);                               // set scrolling region
-    mymove (mcurses_cury, 0);                                                   // goto to current line
-    mcurses_puts_P (SEQ_INSERTLINE);                                            // insert line
-    mysetscrreg (0, 0);                                                         // reset scrolling region
-    mymove (mcurses_cury, mcurses_curx);                                        // restore position
+    uint_fast8_t    n = x - x0;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    if (n <= mcurses_csi_n_cost (n) && mcurses_can_reemit (y, x0, x))
+    {
+        return n;
+    }
+    return mcurses_csi_n_cost (n);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: scroll
+ * INTERN: horizontal relative move in line y from column x0 to column x, returns cost, output only if emit is set
+ *         backwards: BS or CUB, forwards: re-sending the characters, CUF, or TABs followed by one of these
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-scroll (void)
+static uint_fast8_t
+mcurses_hmove (uint_fast8_t y, uint_fast8_t x0, uint_fast8_t x, uint_fast8_t emit)
 {
-    mysetscrreg (mcurses_scrl_start, mcurses_scrl_end);                         // set scrolling region
-    mymove (mcurses_scrl_end, 0);                                               // goto to last line of scrolling region
-    mcurses_puts_P (SEQ_NEXTLINE);                                              // next line
-    mysetscrreg (0, 0);                                                         // reset scrolling region
-    mymove (mcurses_cury, mcurses_curx);                                        // restore position
+    uint_fast8_t    n;
+    uint_fast8_t    cost;
+    uint_fast8_t    tab;
+    uint_fast8_t    ntabs;
+
+    if (x == x0)
+    {
+        return 0;
+    }
+
+    if (x < x0)
+    {
+        n = x0 - x;
+
+        if (n <= mcurses_csi_n_cost (n))                                        // BS: one byte per column
+        {
+            while (emit && n--)
+            {
+                mcurses_putc ('\b');
+            }
+            return x0 - x;
+        }
+
+        if (emit)
+        {
+            mcurses_csi_n (n, SEQ_CURSOR_BACK);
+        }
+        return mcurses_csi_n_cost (n);
+    }
+
+    cost = mcurses_fwd_cost (y, x0, x);
+    tab = x - x % MCURSES_TABSIZE;                                              // last tab stop up to x
+    ntabs = (tab > x0) ? tab / MCURSES_TABSIZE - x0 / MCURSES_TABSIZE : 0;
+
+    if (ntabs && ntabs + mcurses_fwd_cost (y, tab, x) < cost)
+    {
+        cost = ntabs + mcurses_fwd_cost (y, tab, x);
+
+        for (n = 0; emit && n < ntabs; n++)
+        {
+            mcurses_putc ('\t');
+        }
+        x0 = tab;
+    }
+
+    if (emit && x0 < x)
+    {
+        n = x - x0;
+
+        if (n <= mcurses_csi_n_cost (n) && mcurses_can_reemit (y, x0, x))
+        {
+            uint8_t * line = mcurses_shadow_line (y);
+
+            while (x0 < x)
+            {
+                mcurses_putc (line[x0++]);
+            }
+        }
+        else
+        {
+            mcurses_csi_n (n, SEQ_CURSOR_FORWARD);
+        }
+    }
+    return cost;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: clear
+ * INTERN: move the terminal cursor, only if it is not already there
+ *         the cheapest of an absolute move, a relative move or CR followed by a relative move is sent
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-void
-clear (void)
+static void
+mcurses_phy_move (uint_fast8_t y, uint_fast8_t x)
 {
-    mcurses_puts_P (SEQ_CLEAR);
-}
+    uint_fast16_t   best;
+    uint_fast16_t   cost;
+    uint_fast8_t    v;
+    uint_fast8_t    how = 0;                                                    // 0: absolute, 1: relative, 2: CR and relative
 
-/*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: clear to bottom of screen
- *---------------------------------------------------------------------------------------------------------------------------------------------------
+    if (mcurses_phy_y == y && mcurses_phy_x == x)
+    {
+        return;
+    }
+
+    best = mymove_cost (y, x);
+
+    if (mcurses_phy_y < mcurses_lines && x < mcurses_cols && (v = mcurses_vmove (mcurses_phy_y, y, FALSE)) != 0xff)
+    {
+        if (mcurses_phy_x < mcurses_cols)                                       // not with a pending wrap or an unknown column
+        {
+            cost = v + mcurses_hmove (y, mcurses_phy_x, x, FALSE);
+
+            if (cost < best)
+            {
+                best = cost;
+                how = 1;
+            }
+        }
+
+        if (mcurses_phy_x != 0)
+        {
+            cost = 1 + v + mcurses_hmove (y, 0, x, FALSE);
+
+            if (cost < best)
+            {
+                best = cost;
+                how = 2;
+            }
+        }
+    }
+
+    if (how == 0)
+    {
+        mymove (y, x);
+    }
+    else
+    {
+        if (how == 2)
+        {
+            mcurses_putc ('\r');
+            mcurses_phy_x = 0;
+        }
+        mcurses_vmove (mcurses_phy_y, y, TRUE);
+        mcurses_hmove (y, mcurses_phy_x, x, TRUE);
+    }
+    mcurses_phy_y = y;
+    mcurses_phy_x = x;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: bring the terminal cursor to the logical cursor position
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+mcurses_sync (void)
+{
+    mcurses_phy_move (mcurses_cury, mcurses_curx);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: initialize
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+initscr (void)
+{
+    uint_fast8_t rtc;
+
+    if (mcurses_phyio_init ())
+    {
+        mcurses_puts_P (SEQ_LOAD_G1);                                               // load graphic charset into G1
+        mcurses_puts_P (SEQ_AUTOWRAP);                                              // wrapping at the last column is done by the terminal
+        attrset (A_NORMAL);
+        clear ();
+        move (0, 0);
+        mcurses_is_up = 1;
+        rtc = OK;
+    }
+    else
+    {
+        rtc = ERR;
+    }
+    return rtc;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: add character
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+addch (uint_fast8_t ch)
+{
+    mcurses_addch_or_insch (ch, FALSE);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: add string
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+addstr (const char * str)
+{
+    while (*str)
+    {
+        mcurses_addch_or_insch (*str++, FALSE);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: add n characters of a string
+ *          printable characters up to the end of the line are handed to the terminal in one write
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+addnstr (const char * str, uint_fast8_t n)
+{
+    const uint8_t * p = (const uint8_t *) str;
+    uint_fast8_t    len;
+
+    while (n > 0)
+    {
+        mcurses_addch_or_insch (*p, FALSE);                                     // sets replace mode and the cursor position
+
+        if (*p < ' ' || mcurses_phy_x >= mcurses_cols || mcurses_cury >= mcurses_lines)
+        {
+            p++;
+            n--;
+            continue;
+        }
+
+        for (len = 1; len < n && p[len] >= ' ' && mcurses_curx + len - 1 < mcurses_cols; len++)
+        {
+            ;
+        }
+        len--;                                                                  // following characters on the same line
+
+        if (len)
+        {
+            if (mcurses_shadow)
+            {
+                memcpy (mcurses_shadow_line (mcurses_cury) + mcurses_curx, p + 1, len);
+                memset (MCURSES_SHADOW_ATTR (mcurses_shadow_line (mcurses_cury)) + mcurses_curx, mcurses_attr_cell, len);
+            }
+            mcurses_phyio_write (p + 1, len);
+            mcurses_curx += len;
+            mcurses_phy_x += len;
+        }
+        p += len + 1;
+        n -= len + 1;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: add string
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+addstr_P (const char * str)
+{
+    uint_fast8_t ch;
+
+    while ((ch = pgm_read_byte(str)) != '\0')
+    {
+        mcurses_addch_or_insch (ch, FALSE);
+        str++;
+    }
+}
+
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: append SGR parameter p to the parameter list buf of length n, returns new length
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast8_t
+mcurses_sgr_add (char * buf, uint_fast8_t n, uint_fast8_t p)
+{
+    if (n)
+    {
+        buf[n++] = ';';
+    }
+    if (p >= 10)
+    {
+        buf[n++] = p / 10 + '0';
+    }
+    buf[n++] = p % 10 + '0';
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: set attribute(s)
+ *          if the attributes on the terminal are known, only the changes are sent when this is shorter than a reset
+ *          followed by all attributes, e.g. "\033[32m" instead of "\033[0;32;40m"
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+attrset (uint_fast16_t attr)
+{
+    char                delta[32];                                              // SGR parameters of the change
+    uint_fast8_t        n = 0;
+    uint_fast8_t        full = 4;                                               // length of "\033[0" ... "m"
+    uint_fast16_t       on;
+    uint_fast16_t       off;
+    uint_fast8_t        idx;
+
+    if (attr == mcurses_attr)
+    {
+        return;
+    }
+
+    if (mcurses_attr != 0xffff)
+    {
+        on  = attr & ~mcurses_attr & 0xff;
+        off = mcurses_attr & ~attr & 0xff;
+
+        if (off & (A_BOLD | A_DIM))                                             // 22 resets both bold and dim
+        {
+            n = mcurses_sgr_add (delta, n, 22);
+            on |= attr & (A_BOLD | A_DIM);
+        }
+        if (off & A_UNDERLINE)
+        {
+            n = mcurses_sgr_add (delta, n, 24);
+        }
+        if (off & A_BLINK)
+        {
+            n = mcurses_sgr_add (delta, n, 25);
+        }
+        if (off & A_REVERSE)
+        {
+            n = mcurses_sgr_add (delta, n, 27);
+        }
+
+        if ((attr ^ mcurses_attr) & F_COLOR)
+        {
+            idx = (attr & F_COLOR) >> 8;
+            n = mcurses_sgr_add (delta, n, (idx >= 1 && idx <= 8) ? 30 + idx - 1 : 39);
+        }
+        if ((attr ^ mcurses_attr) & B_COLOR)
+        {
+            idx = (attr & B_COLOR) >> 12;
+            n = mcurses_sgr_add (delta, n, (idx >= 1 && idx <= 8) ? 40 + idx - 1 : 49);
+        }
+
+        if (on & A_REVERSE)
+        {
+            n = mcurses_sgr_add (delta, n, 7);
+        }
+        if (on & A_UNDERLINE)
+        {
+            n = mcurses_sgr_add (delta, n, 4);
+        }
+        if (on & A_BLINK)
+        {
+            n = mcurses_sgr_add (delta, n, 5);
+        }
+        if (on & A_BOLD)
+        {
+            n = mcurses_sgr_add (delta, n, 1);
+        }
+        if (on & A_DIM)
+        {
+            n = mcurses_sgr_add (delta, n, 2);
+        }
+
+        idx = (attr & F_COLOR) >> 8;
+        full += (idx >= 1 && idx <= 8) ? 3 : 0;
+        idx = (attr & B_COLOR) >> 12;
+        full += (idx >= 1 && idx <= 8) ? 3 : 0;
+
+        for (on = attr & (A_REVERSE | A_UNDERLINE | A_BLINK | A_BOLD | A_DIM); on; on &= on - 1)
+        {
+            full += 2;
+        }
+    }
+
+    if (n && n + 3 < full)                                                      // "\033[" delta "m"
+    {
+        mcurses_puts_P (SEQ_CSI);
+        mcurses_phyio_write ((const uint8_t *) delta, n);
+        mcurses_putc ('m');
+    }
+    else
+    {
+        mcurses_puts_P (SEQ_ATTRSET);
+
+        idx = (attr & F_COLOR) >> 8;
+
+        if (idx >= 1 && idx <= 8)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_FCOLOR);
+            mcurses_putc (idx - 1 + '0');
+        }
+
+        idx = (attr & B_COLOR) >> 12;
+
+        if (idx >= 1 && idx <= 8)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_BCOLOR);
+            mcurses_putc (idx - 1 + '0');
+        }
+
+        if (attr & A_REVERSE)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_REVERSE);
+        }
+        if (attr & A_UNDERLINE)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_UNDERLINE);
+        }
+        if (attr & A_BLINK)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_BLINK);
+        }
+        if (attr & A_BOLD)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_BOLD);
+        }
+        if (attr & A_DIM)
+        {
+            mcurses_puts_P (SEQ_ATTRSET_DIM);
+        }
+        mcurses_putc ('m');
+    }
+    mcurses_attr = attr;
+    mcurses_attr_cell = mcurses_attr8 (attr);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: attributes as one byte for a cell attribute plane, 0xff = not representable
+ *          0x00..0x1f: A_UNDERLINE, A_REVERSE, A_BLINK, A_BOLD, A_DIM without colors
+ *          0x80..0xbf: colors without flags, bits 5..3 = background (B_BLACK..B_WHITE), bits 2..0 = foreground (0 = default, F_BLACK..F_CYAN)
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+mcurses_attr8 (uint_fast16_t attr)
+{
+    uint_fast8_t    fg = (attr & F_COLOR) >> 8;
+    uint_fast8_t    bg = (attr & B_COLOR) >> 12;
+
+    if (attr == 0xffff)
+    {
+        return 0xff;
+    }
+
+    if (! fg && ! bg)
+    {
+        return (attr & 0xff) <= 0x1f ? (attr & 0x1f) : 0xff;
+    }
+
+    if ((attr & 0xff) || bg < 1 || bg > 8 || fg > 7)
+    {
+        return 0xff;
+    }
+    return 0x80 | ((bg - 1) << 3) | fg;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: attributes of a cell attribute byte (see mcurses_attr8()), 0xff gives A_NORMAL
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+mcurses_attr16 (uint_fast8_t a)
+{
+    if (a == 0xff)
+    {
+        return A_NORMAL;
+    }
+
+    if (a & 0x80)
+    {
+        return ((((a >> 3) & 7) + 1) << 12) | ((a & 7) << 8);
+    }
+    return a & 0x1f;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: move cursor
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+move (uint_fast8_t y, uint_fast8_t x)
+{
+    mcurses_cury = y;                                                           // output is deferred until mcurses_sync()
+    mcurses_curx = x;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: delete line
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+deleteln (void)
+{
+    mcurses_phy_setscrreg (mcurses_scrl_start, mcurses_scrl_end);               // set scrolling region
+    mcurses_phy_move (mcurses_cury, 0);                                         // goto to current line
+    mcurses_puts_P (SEQ_DELETELINE);                                            // delete line
+    mcurses_phy_x = 0xff;                                                       // column after DL differs between terminals
+
+    if (mcurses_cury >= mcurses_scrl_start && mcurses_cury <= mcurses_scrl_end)
+    {
+        mcurses_shadow_scroll (mcurses_cury, mcurses_scrl_end, TRUE);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: insert line
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+insertln (void)
+{
+    mcurses_phy_setscrreg (mcurses_scrl_start, mcurses_scrl_end);               // IL shifts lines down to the bottom margin
+    mcurses_phy_move (mcurses_cury, 0);                                         // goto to current line
+    mcurses_puts_P (SEQ_INSERTLINE);                                            // insert line
+    mcurses_phy_x = 0xff;                                                       // column after IL differs between terminals
+
+    if (mcurses_cury >= mcurses_scrl_start && mcurses_cury <= mcurses_scrl_end)
+    {
+        mcurses_shadow_scroll (mcurses_cury, mcurses_scrl_end, FALSE);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: scroll
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+scroll (void)
+{
+    mcurses_phy_setscrreg (mcurses_scrl_start, mcurses_scrl_end);               // set scrolling region (kept afterwards)
+
+    if (mcurses_phy_x == mcurses_cols)                                          // wrap pending: CR cancels it
+    {
+        mcurses_putc ('\r');
+        mcurses_phy_x = 0;
+    }
+
+    if (mcurses_phy_y != mcurses_scrl_end || mcurses_phy_x == 0xff)
+    {
+        mcurses_phy_move (mcurses_scrl_end, 0);                                 // goto to last line of scrolling region
+    }
+    mcurses_putc ('\n');                                                        // LF on the bottom margin scrolls up
+    mcurses_shadow_scroll (mcurses_scrl_start, mcurses_scrl_end, TRUE);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: clear
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+clear (void)
+{
+    if (mcurses_phy_x == mcurses_cols)
+    {
+        mcurses_phy_y = mcurses_phy_x = 0xff;                                   // ED may or may not cancel a pending wrap
+    }
+    mcurses_puts_P (SEQ_CLEAR);
+
+    if (mcurses_shadow)
+    {
+        memset (mcurses_shadow, ' ', mcurses_lines * mcurses_cols);
+        memset (MCURSES_SHADOW_ATTR (mcurses_shadow), mcurses_attr_cell, mcurses_lines * mcurses_cols);
+        mcurses_shadow_top = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: clear to bottom of screen
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 void
 clrtobot (void)
 {
+    mcurses_sync ();
     mcurses_puts_P (SEQ_CLRTOBOT);
+    mcurses_shadow_clear (mcurses_cury, mcurses_curx, TRUE);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -460,7 +1188,9 @@ clrtobot (void)
 void
 clrtoeol (void)
 {
+    mcurses_sync ();
     mcurses_puts_P (SEQ_CLRTOEOL);
+    mcurses_shadow_clear (mcurses_cury, mcurses_curx, FALSE);
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -470,7 +1200,19 @@ clrtoeol (void)
 void
 delch (void)
 {
+    mcurses_sync ();
     mcurses_puts_P (SEQ_DELCH);
+
+    if (mcurses_shadow && mcurses_cury < mcurses_lines && mcurses_curx < mcurses_cols)
+    {
+        uint8_t * line = mcurses_shadow_line (mcurses_cury);
+        uint8_t * attrs = MCURSES_SHADOW_ATTR (line);
+
+        memmove (line + mcurses_curx, line + mcurses_curx + 1, mcurses_cols - mcurses_curx - 1);
+        memmove (attrs + mcurses_curx, attrs + mcurses_curx + 1, mcurses_cols - mcurses_curx - 1);
+        line[mcurses_cols - 1] = ' ';
+        attrs[mcurses_cols - 1] = mcurses_attr_cell;
+    }
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -494,9 +1236,180 @@ setscrreg (uint_fast8_t t, uint_fast8_t b)
     mcurses_scrl_end = b;
 }
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: set screen size at runtime
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+resizeterm (uint_fast8_t lines, uint_fast8_t cols)
+{
+    mcurses_lines = lines;
+    mcurses_cols = cols;
+    mcurses_phy_y = mcurses_phy_x = 0xff;
+    mcurses_shadow = 0;                                                         // size changed: the caller has to set a new shadow buffer
+    mcurses_scrl_start = 0;
+    mcurses_scrl_end = lines - 1;
+
+    if (mcurses_is_up)
+    {
+        mcurses_phy_setscrreg (0, lines - 1);                                   // a known region allows relative vertical moves
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: set shadow buffer (2 * lines * cols bytes: characters, attributes) holding what the terminal shows, 0 = do not use a shadow buffer
+ *          the contents are unknown until the next clear()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+mcurses_setshadow (uint8_t * buf)
+{
+    mcurses_shadow = buf;
+    mcurses_shadow_top = 0;
+
+    if (buf)
+    {
+        memset (buf, 0, 2 * mcurses_lines * mcurses_cols);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: wanted attribute byte of cell x for mcurses_updline(), no attribute plane or 0xff = normal
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast8_t
+mcurses_upd_attr (const uint8_t * attrs, uint_fast8_t x)
+{
+    return (attrs && attrs[x] != 0xff) ? attrs[x] : 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: show line y with the contents of line[0..cols-1] (0 and control codes = blank) and their attribute bytes
+ *          attrs[0..cols-1] (see mcurses_attr8(), 0 = no attribute plane: all normal)
+ *          with a shadow buffer only changed cells are sent: short unchanged gaps are re-sent instead of moving
+ *          the cursor, a blank tail is cleared with EL if enough cells change. Double-byte characters (Shift-JIS)
+ *          are always sent as a whole. Attributes are only set where they change from one written run to the next,
+ *          the current attributes are restored at the end. The cursor is left behind the last written cell.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+mcurses_updline (uint_fast8_t y, const uint8_t * line, const uint8_t * attrs)
+{
+    uint8_t *       sline;
+    uint8_t *       sattrs;
+    uint_fast8_t    x;
+    uint_fast8_t    i;
+    uint_fast8_t    a;                                                          // wanted attribute byte of the character at x
+    uint_fast8_t    w;                                                          // width of the character at x
+    uint_fast8_t    tail;                                                       // start of the blank tail of line
+    uint_fast8_t    limit;                                                      // end of the cells compared one by one
+    uint_fast8_t    ndiff;
+    uint_fast8_t    changed;
+    uint_fast8_t    trail = FALSE;                                              // terminal shows the 2nd byte of a double-byte character at x
+    uint_fast8_t    wend = 0xff;                                                // column after the last written cell, 0xff = nothing written
+    uint_fast16_t   saved = mcurses_attr;                                       // attributes of the caller
+
+    if (y >= mcurses_lines)
+    {
+        return;
+    }
+
+    if (! mcurses_shadow)                                                       // no shadow: rewrite the whole line
+    {
+        attrset (A_NORMAL);
+        move (y, 0);
+        clrtoeol ();
+
+        for (x = 0; x < mcurses_cols; x++)
+        {
+            if (line[x])
+            {
+                attrset (mcurses_attr16 (mcurses_upd_attr (attrs, x)));
+                mcurses_addch_or_insch (line[x], FALSE);
+            }
+        }
+    }
+    else
+    {
+        sline = mcurses_shadow_line (y);
+        sattrs = MCURSES_SHADOW_ATTR (sline);
+
+        for (tail = mcurses_cols; tail > 0 && MCURSES_CELL (line[tail - 1]) == ' ' && ! mcurses_upd_attr (attrs, tail - 1); tail--)
+        {
+            ;
+        }
+
+        for (ndiff = 0, x = tail; x < mcurses_cols; x++)
+        {
+            if (sline[x] != ' ' || sattrs[x])
+            {
+                ndiff++;
+            }
+        }
+        limit = (ndiff >= MCURSES_UPD_EL) ? tail : mcurses_cols;
+
+        for (x = 0; x < limit; x += w)
+        {
+            w = (MCURSES_SJIS1 (line[x]) && x + 1 < limit) ? 2 : 1;
+            a = mcurses_upd_attr (attrs, x);
+            changed = trail;                                                    // a double-byte character on the terminal would be cut
+
+            for (i = 0; i < w; i++)
+            {
+                if (sline[x + i] != MCURSES_CELL (line[x + i]) || sattrs[x + i] != a)
+                {
+                    changed = TRUE;
+                }
+                trail = (! trail && MCURSES_SJIS1 (sline[x + i]));
+            }
+
+            if (changed)
+            {
+                attrset (mcurses_attr16 (a));
+
+                for (i = (wend != 0xff) ? wend : x; i < x && mcurses_upd_attr (attrs, i) == a; i++)
+                {
+                    ;                                                           // a re-sent gap has to have the same attributes
+                }
+
+                if (wend != 0xff && x - wend <= MCURSES_UPD_GAP && i == x)      // cheaper to re-send the unchanged cells
+                {
+                    for ( ; wend < x; wend++)
+                    {
+                        mcurses_addch_or_insch (MCURSES_CELL (line[wend]), FALSE);
+                    }
+                }
+                else
+                {
+                    move (y, x);
+                }
+
+                for (i = 0; i < w; i++)
+                {
+                    mcurses_addch_or_insch (MCURSES_CELL (line[x + i]), FALSE);
+                }
+                wend = x + w;
+            }
+        }
+
+        if (limit < mcurses_cols)
+        {
+            attrset (A_NORMAL);
+            move (y, tail);
+            clrtoeol ();
+        }
+    }
+
+    if (saved != 0xffff)
+    {
+        attrset (saved);
+    }
+}
+
 void
 curs_set (uint_fast8_t visibility)
 {
+    mcurses_sync ();
     mcurses_puts_P (SEQ_CURSOR_VIS);
 
     if (visibility == 0)
@@ -517,6 +1430,7 @@ curs_set (uint_fast8_t visibility)
 void
 refresh (void)
 {
+    mcurses_sync ();
     mcurses_phyio_flush_output ();
 }
 
@@ -544,97 +1458,178 @@ halfdelay (uint_fast8_t tenths)
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * MCURSES: read key
+ * MCURSES: key decoder
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 
-#define MAX_KEYS    (23)
-#define KW(k,s) const char k[] PROGMEM=s  // キーワード定義マクロ
-KW(k00,"B");  KW(k01,"A");  KW(k02,"D");  KW(k03,"C");  KW(k04,"1~"); 
-KW(k05,"3~"); KW(k06,"2~"); KW(k07,"6~"); KW(k08,"5~"); KW(k09,"4~");
-KW(k10,"Z");  KW(k11,"11~");KW(k12,"12~");KW(k13,"13~");KW(k14,"14~");
-KW(k15,"15~");KW(k16,"17~");KW(k17,"18~");KW(k18,"19~");KW(k19,"20~");
-KW(k20,"21~");KW(k21,"23~");KW(k22,"24~");
+#define MCURSES_KEY_NONE        0                                           // no sequence pending
+#define MCURSES_KEY_ESC         1                                           // ESC received
+#define MCURSES_KEY_CSI         2                                           // ESC [ received, reading first parameter
+#define MCURSES_KEY_CSI_PARAM   3                                           // ESC [ received, skipping further parameters
+#define MCURSES_KEY_SS3         4                                           // ESC O received
 
-const char* const function_keys[] PROGMEM = {
-  k00,k01,k02,k03,k04,k05,k06,k07,k08,k09,
-  k10,k11,k12,k13,k14,k15,k16,k17,k18,k19,
-  k20,k21,k22,
-};
+static uint_fast8_t             mcurses_key_state = MCURSES_KEY_NONE;       // state of the escape sequence decoder
+static uint_fast8_t             mcurses_key_num;                            // first numeric parameter of CSI sequence
+
+#define MCURSES_TILDE_KEYS      25
 
-const char const function_keys_code[] PROGMEM = {
-  KEY_DOWN   ,                // Down arrow key
-  KEY_UP     ,                // Up arrow key
-  KEY_LEFT   ,                // Left arrow key
-  KEY_RIGHT  ,                // Right arrow key
-  KEY_HOME   ,               // Home key
-  KEY_DC     ,               // Delete character key
-  KEY_IC     ,               // Ins char/toggle ins mode key
-  KEY_NPAGE  ,               // Next-page key
-  KEY_PPAGE  ,               // Previous-page key
-  KEY_END    ,               // End key
-  KEY_BTAB   ,               // Back tab key
-  KEY_F1     ,               // Function key F1
-  KEY_F2     ,               // Function key F2
-  KEY_F3     ,               // Function key F3
-  KEY_F4     ,               // Function key F4
-  KEY_F5     ,               // Function key F5
-  KEY_F6     ,               // Function key F6
-  KEY_F7     ,               // Function key F7
-  KEY_F8     ,               // Function key F8
-  KEY_F9     ,               // Function key F9
-  KEY_F10    ,               // Function key F10
-  KEY_F11    ,               // Function key F11
-  KEY_F12    ,               // Function key F12
+static const uint8_t mcurses_tilde_keys[MCURSES_TILDE_KEYS] PROGMEM =       // key codes of ESC [ n ~, index n
+{
+    ERR,        KEY_HOME,   KEY_IC,     KEY_DC,     KEY_END,                //  0 -  4
+    KEY_PPAGE,  KEY_NPAGE,  ERR,        ERR,        ERR,                    //  5 -  9
+    ERR,        KEY_F1,     KEY_F2,     KEY_F3,     KEY_F4,                 // 10 - 14
+    KEY_F5,     ERR,        KEY_F6,     KEY_F7,     KEY_F8,                 // 15 - 19
+    KEY_F9,     KEY_F10,    ERR,        KEY_F11,    KEY_F12,                // 20 - 24
 };
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * INTERN: key code of final byte of CSI / SS3 sequence
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast8_t
+mcurses_key_final (uint_fast8_t ch)
+{
+    switch (ch)
+    {
+        case 'A':   return KEY_UP;
+        case 'B':   return KEY_DOWN;
+        case 'C':   return KEY_RIGHT;
+        case 'D':   return KEY_LEFT;
+        case 'H':   return KEY_HOME;
+        case 'F':   return KEY_END;
+        case 'Z':   return KEY_BTAB;
+        case 'P':   return KEY_F1;
+        case 'Q':   return KEY_F2;
+        case 'R':   return KEY_F3;
+        case 'S':   return KEY_F4;
+        case '~':
+            if (mcurses_key_num < MCURSES_TILDE_KEYS)
+            {
+                return pgm_read_byte(&mcurses_tilde_keys[mcurses_key_num]);
+            }
+            break;
+    }
+    return ERR;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: decode one received byte
+ *
+ * Escape sequences are decoded incrementally, one byte per call, without waiting for further bytes.
+ * Returns the key code, or ERR while a sequence is pending and for unknown sequences.
+ * A bare ESC cannot be told apart from the start of a sequence here: the caller ends it with mcurses_keytimeout().
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+mcurses_keyin (uint_fast8_t ch)
+{
+    switch (mcurses_key_state)
+    {
+        case MCURSES_KEY_ESC:
+            if (ch == '[')
+            {
+                mcurses_key_state = MCURSES_KEY_CSI;
+                mcurses_key_num = 0;
+                return ERR;
+            }
+            if (ch == 'O')
+            {
+                mcurses_key_state = MCURSES_KEY_SS3;
+                return ERR;
+            }
+            mcurses_key_state = MCURSES_KEY_NONE;
+            return (ch == '\033') ? KEY_ESCAPE : ERR;                            // 2 x ESCAPE, other sequences are ignored
+
+        case MCURSES_KEY_CSI:
+            if (ch >= '0' && ch <= '9')
+            {
+                if (mcurses_key_num < MCURSES_TILDE_KEYS)
+                {
+                    mcurses_key_num = mcurses_key_num * 10 + ch - '0';
+                }
+                return ERR;
+            }
+            // fall through
+        case MCURSES_KEY_CSI_PARAM:
+            if (ch < 0x40)                                                      // further parameters (modifiers) are ignored
+            {
+                mcurses_key_state = MCURSES_KEY_CSI_PARAM;
+                return ERR;
+            }
+            // fall through
+        case MCURSES_KEY_SS3:
+            mcurses_key_state = MCURSES_KEY_NONE;
+            return mcurses_key_final (ch);
+    }
+
+    if (ch == '\033')
+    {
+        mcurses_key_state = MCURSES_KEY_ESC;
+        return ERR;
+    }
+    if (ch == 0x7F)                                                             // BACKSPACE on VT200 sends DEL char
+    {
+        return KEY_BACKSPACE;                                                   // map it to '\b'
+    }
+    return ch;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: end a pending escape sequence (no further bytes arrived in time)
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+mcurses_keytimeout (void)
+{
+    uint_fast8_t state = mcurses_key_state;
+
+    mcurses_key_state = MCURSES_KEY_NONE;
+    return (state == MCURSES_KEY_ESC) ? KEY_ESCAPE : ERR;
+}
+
+uint_fast8_t
+mcurses_keypending (void)
+{
+    return mcurses_key_state != MCURSES_KEY_NONE;
+}
+
+void
+mcurses_keyreset (void)
+{
+    mcurses_key_state = MCURSES_KEY_NONE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * MCURSES: read key (waits for the rest of an escape sequence)
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
 uint_fast8_t
-getch (void) {
-    char    buf[4];
+getch (void)
+{
     uint_fast8_t ch;
-    uint_fast8_t idx;
 
     refresh ();
-    ch = mcurses_phyio_getc ();
 
-    if (ch == 0x7F) {                                                           // BACKSPACE on VT200 sends DEL char
-          ch = KEY_BACKSPACE;                                                   // map it to '\b'
-    } else if (ch == '\033') {                                                  // ESCAPE   
-        while ((ch = mcurses_phyio_getc ()) == ERR)  {
-            ;
-        }
+    for (;;)
+    {
+        ch = mcurses_phyio_getc ();
 
-        if (ch == '\033') {                                                     // 2 x ESCAPE
-            return KEY_ESCAPE;
-        } else if (ch == '[') {
-            for (idx = 0; idx < 3; idx++) {
-                while ((ch = mcurses_phyio_getc ()) == ERR)  {
-                    ;
-                }
-                buf[idx] = ch;
-                if ((ch >= 'A' && ch <= 'Z') || ch == '~')  {
-                    idx++;
-                    break;
-                }
+        if (ch == ERR)
+        {
+            if (mcurses_key_state != MCURSES_KEY_NONE)
+            {
+                continue;
             }
+            return ERR;
+        }
 
-            buf[idx] = '\0';
-
-            for (idx = 0; idx < MAX_KEYS; idx++)  {
-               if (!strcmp_P(buf,(char*)pgm_read_word(&function_keys[idx])))   {
-                  ch = pgm_read_byte(&function_keys_code[idx]);
-                  break;
-                }
-            }
+        ch = mcurses_keyin (ch);
 
-            if (idx == MAX_KEYS)  {
-                ch = ERR;
-            }
-        }  else  {
-            ch = ERR;
+        if (ch != ERR || mcurses_key_state == MCURSES_KEY_NONE)
+        {
+            return ch;
         }
     }
-    return ch;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -731,7 +1726,8 @@ getnstr (char * str, uint_fast8_t maxlen)
 void
 endwin (void)
 {
-    move (LINES - 1, 0);                                                        // move cursor to last line
+    mcurses_phy_setscrreg (0, 0);                                               // reset scrolling region
+    move (mcurses_lines - 1, 0);                                                // move cursor to last line
     clrtoeol ();                                                                // clear this line
     mcurses_putc ('\017');                                                      // switch to G0 set
     curs_set (TRUE);                                                            // show cursor
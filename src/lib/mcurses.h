@@ -18,6 +18,11 @@
 // 修正 2018/01/30 キーコードの変更（全角文字シフトJIS対応のため）
 // 修正 2018/03/01 CTRLキー定義の追加
 // 修正 2018/08/23 KEY_LF等のキー定義の追加
+// 修正 2026/10/18 mcurses_sync()、resizeterm()の追加
+// 修正 2026/10/18 mcurses_setshadow()、mcurses_updline()の追加
+// 修正 2026/10/18 addnstr()、setFunction_write()の追加
+// 修正 2026/10/18 キー入力の逐次復号 mcurses_keyin()、mcurses_keytimeout()、mcurses_keypending()、mcurses_keyreset()の追加
+// 修正 2026/10/18 mcurses_attr8()、mcurses_attr16()の追加、mcurses_updline()に属性の引数を追加
 //
 
 
@@ -96,11 +101,15 @@ extern uint_fast8_t             mcurses_curx;
  */
 void                     setFunction_putchar(void (*functionPoitner)(uint8_t ch));
 void                     setFunction_getchar(char (*functionPoitner)(void));
+void                     setFunction_write(void (*functionPoitner)(const uint8_t * buf, uint_fast8_t len));
 uint_fast8_t             initscr (void);                                     // initialize mcurses
 void                     move (uint_fast8_t, uint_fast8_t);                  // move cursor to line, column (home = 0, 0)
 void                     attrset (uint_fast16_t);                            // set attribute(s)
+uint_fast8_t             mcurses_attr8 (uint_fast16_t);                      // attributes as cell attribute byte, 0xff = not representable
+uint_fast16_t            mcurses_attr16 (uint_fast8_t);                      // attributes of a cell attribute byte
 void                     addch (uint_fast8_t);                               // add a character
 void                     addstr (const char *);                              // add a string
+void                     addnstr (const char *, uint_fast8_t);               // add n characters of a string
 void                     addstr_P (const char *);                            // add a string (PROGMEM)
 void                     getnstr (char * str, uint_fast8_t maxlen);          // read a string (with mini editor functionality)
 void                     setscrreg (uint_fast8_t, uint_fast8_t);             // set scrolling region
@@ -115,8 +124,16 @@ void                     insch (uint_fast8_t);                               //
 void                     nodelay (uint_fast8_t);                             // set/reset nodelay
 void                     halfdelay (uint_fast8_t);                           // set/reset halfdelay
 uint_fast8_t             getch (void);                                       // read key
+uint_fast8_t             mcurses_keyin (uint_fast8_t);                       // decode one received byte: key code or ERR (sequence pending/ignored)
+uint_fast8_t             mcurses_keytimeout (void);                          // end a pending sequence: KEY_ESCAPE for a bare ESC, else ERR
+uint_fast8_t             mcurses_keypending (void);                          // TRUE if an escape sequence is pending
+void                     mcurses_keyreset (void);                            // discard a pending escape sequence
 void                     curs_set(uint_fast8_t);                             // set cursor to: 0=invisible 1=normal 2=very visible
 void                     refresh (void);                                     // flush output
+void                     mcurses_sync (void);                                // move terminal cursor to the logical position
+void                     resizeterm (uint_fast8_t, uint_fast8_t);            // set number of lines/columns
+void                     mcurses_setshadow (uint8_t *);                      // set shadow buffer (2 * lines * cols bytes), 0 = none
+void                     mcurses_updline (uint_fast8_t, const uint8_t *, const uint8_t *); // show a line with attributes, sending only changed cells
 void                     endwin (void);                                      // end mcurses
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
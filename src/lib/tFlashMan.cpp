@@ -3,6 +3,14 @@
 // 2017/11/07 by たま吉さん
 // 2018/08/18 by たま吉さん,システム設定にNTSC横・縦補正の追加
 // 2018/10/04 by たま吉さん,write()の追加
+// 2026/10/18 saveProgram()、loadProgram()をプログラム長分の差分書込み・読込みに変更
+// 2026/10/18 プログラム保存領域を固定スロットからログ構造(可変長レコード)に変更
+// 2026/10/18 ページ別消去回数の記録、getEraseCount()の追加
+// 2026/10/18 getPrgSize()の追加
+// 2026/10/18 プログラムのLZ圧縮保存、readPrg()の追加
+// 2026/10/18 旧形式(固定スロット)の保存領域は消去せず読出しのみとする、format()の追加
+// 2026/10/18 電源断で書込み中断のレコードの回収(走査時)、空き不足でも削除可能に修正
+// 2026/10/18 アドレスからポインタへの変換をuintptr_t経由に変更(64ビットのホスト上のテストでの警告対策)
 //
 
 #include "tFlashMan.h"
@@ -28,21 +36,165 @@ static uint8_t eeperrorTo(uint16_t status) {
    return rc;
 }
 
+// CRC16(CCITT)の計算
+// 引数
+//  p   : データ
+//  len : バイト数
+//  crc : 初期値(続きの計算の場合は前回の値)
+// 戻り値
+//  CRC16値
+static uint16_t crc16(const uint8_t* p, uint16_t len, uint16_t crc = 0xffff) {
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// LZ圧縮データの出力先
+typedef struct {
+  uint16_t* dst;          // 書込み先(NULL:バイト数とCRCの計算のみ)
+  uint16_t  len;          // 出力バイト数
+  uint16_t  crc;          // 出力データのCRC16
+  uint16_t  hw;           // 書込み待ちの下位バイト
+  TFLASH_Status status;   // 書込み結果
+} LzOut;
+
+// LZ圧縮データの1バイト出力
+// 引数
+//  o   : 出力先
+//  c   : データ
+// フラッシュメモリには2バイト揃うごとに半ワード単位で書き込む
+static void lzPut(LzOut* o, uint8_t c) {
+  o->crc = crc16(&c, 1, o->crc);
+  if (!(o->len & 1))
+    o->hw = c;
+  else if (o->dst && o->status == TFLASH_COMPLETE)
+    o->status = TFlash.write(o->dst + o->len / 2, o->hw | (uint16_t)c << 8);
+  o->len++;
+}
+
+// LZ圧縮(LZSS)
+// 引数
+//  src : 圧縮するデータ
+//  len : バイト数
+//  o   : 出力先
+// (メモ)
+//  参照窓内の最長一致を総当たりで探す。出力はフラグと最大8項目(17バイト)ずつまとめて行い、
+//  奇数バイトで終わる場合は最後の半ワードの上位を0xFFとする
+static void lzPack(const uint8_t* src, uint16_t len, LzOut* o) {
+  uint8_t  grp[1 + 8 * 2];  // フラグ + 8項目
+  uint8_t  g = 1, bit = 0;
+  uint16_t i = 0, j, l, lim, best, dist = 0;
+
+  grp[0] = 0;
+  while (i < len) {
+    // 参照窓内の最長一致の探索
+    best = 0;
+    lim = i > PRG_LZ_WINDOW ? i - PRG_LZ_WINDOW : 0;
+    for (j = i; j-- > lim; ) {
+      if (src[j] != src[i])
+        continue;
+      for (l = 1; l < PRG_LZ_MAXLEN && i + l < len && src[j + l] == src[i + l]; l++);
+      if (l > best) {
+        best = l;
+        dist = i - j;
+        if (l == PRG_LZ_MAXLEN)
+          break;
+      }
+    }
+
+    if (best >= PRG_LZ_MINLEN) {
+      grp[g++] = dist & 0xff;
+      grp[g++] = (dist >> 8) << 4 | (best - PRG_LZ_MINLEN);
+      i += best;
+    } else {
+      grp[0] |= 1 << bit;
+      grp[g++] = src[i++];
+    }
+    if (++bit == 8 || i == len) {
+      for (j = 0; j < g; j++)
+        lzPut(o, grp[j]);
+      grp[0] = 0;
+      g = 1;
+      bit = 0;
+    }
+  }
+  if (o->dst && (o->len & 1) && o->status == TFLASH_COMPLETE)
+    o->status = TFlash.write(o->dst + o->len / 2, o->hw | 0xff00);
+}
+
+// LZ圧縮データの展開・照合
+// 引数
+//  src    : 圧縮データ
+//  srcLen : 圧縮データのバイト数
+//  dst    : 展開先(照合時は照合対象)
+//  dstLen : 展開するバイト数(途中までの展開も可)
+//  cmp    : 0:展開 1:照合
+// 戻り値
+//  展開(照合一致)したバイト数
+// 照合時は照合対象をそのまま参照窓とする(不一致の時点で終了するため、それまでは展開結果と同じ)
+static uint16_t lzUnpack(const uint8_t* src, uint16_t srcLen, uint8_t* dst, uint16_t dstLen, uint8_t cmp) {
+  const uint8_t* end = src + srcLen;
+  uint16_t n = 0, dist, l;
+  uint8_t  flg = 0, c;
+
+  for (uint8_t bit = 0; n < dstLen && src < end; bit = (bit + 1) & 7) {
+    if (!bit)
+      flg = *src++;
+    if (flg & (1 << bit)) {
+      // リテラル
+      if (src >= end)
+        break;
+      l = 1;
+      dist = 0;
+    } else {
+      // 一致
+      if (src + 2 > end)
+        break;
+      dist = src[0] | (src[1] >> 4) << 8;
+      l = (src[1] & 0x0f) + PRG_LZ_MINLEN;
+      src += 2;
+      if (!dist || dist > n)
+        break;  // 不正なデータ
+    }
+    for (; l && n < dstLen; l--, n++) {
+      c = dist ? dst[n - dist] : *src++;
+      if (!cmp)
+        dst[n] = c;
+      else if (dst[n] != c)
+        return n;
+    }
+  }
+  return n;
+}
+
 // 初期設定
 //   フラッシュメモリ利用のための初期化を行う
 // 引数
 //   totalPageNum  ：総ページ数
 //   pageSize      ：1ページ内バイト数
-//   prgPageNum    ：1プログラム当たりのページ数
+//   maxPrgNum     ：プログラム保存可能数(FLASH_PRG_MAX以下)
+//   prgPageNum    ：1プログラム当たりの最大ページ数
+//   areaPageNum   ：プログラム保存領域のページ数
 //
-void tFlashMan::init(uint16_t totalPageNum, uint16_t pageSize, uint16_t maxPrgNum, uint16_t prgPageNum) {
+void tFlashMan::init(uint16_t totalPageNum, uint16_t pageSize, uint16_t maxPrgNum, uint16_t prgPageNum, uint16_t areaPageNum) {
   _totalPageNum = totalPageNum ; // 総ページ数
   _pageSize     = pageSize ;     // 1ページ内バイト数
-  _maxPrgNum    = maxPrgNum;     // プログラム保存可能数
-  _prgPageNum   = prgPageNum ;   // 1プログラム当たりのページ数
+  _maxPrgNum    = maxPrgNum < FLASH_PRG_MAX ? maxPrgNum : FLASH_PRG_MAX; // プログラム保存可能数
+  _prgPageNum   = prgPageNum ;   // 1プログラム当たりの最大ページ数
+  _areaPageNum  = areaPageNum;   // プログラム保存領域のページ数
   
   // プログラム保存先頭ページ番号の計算
-  _topPrgPageNo = _totalPageNum - _prgPageNum * _maxPrgNum - FLATH_EEPROM_USE;
+  _topPrgPageNo = _totalPageNum - _areaPageNum - FLATH_EEPROM_USE;
+  _areaTop  = FLASH_START_ADDRESS + (uint32_t)_topPrgPageNo * _pageSize;
+  _areaSize = _areaPageNum * _pageSize;
+  _head = _tail = 0;
+  _seq  = 0;
+  _legacy = 0;
+  for (uint8_t i = 0; i < FLASH_PRG_MAX; i++)
+    _dir[i] = PRGREC_NONE;
   
   // EEPROM(エミュレーション)の利用設定
   EEPROM.PageBase0 = (uint32_t)(FLASH_START_ADDRESS + (_totalPageNum-2) * (uint32_t)_pageSize);
@@ -51,35 +203,6 @@ void tFlashMan::init(uint16_t totalPageNum, uint16_t pageSize, uint16_t maxPrgNu
 
 }
 
-//
-// 指定プログラムの消去
-// 引数
-//   prgNo  ：プログラム番号
-// 戻り値
-//   0: 正常終了、0以外:異常終了
-//
-uint8_t tFlashMan::eraceProgram( uint8_t prgNo ) {
-  TFLASH_Status status; // フラッシュメモリ操作ステータス
-  uint8_t rc = 0;       // 関数戻り値
-
-  // 書き込みロック解除
-  TFlash.unlock();
-
-  // ページ単位の消去処理
-  for (uint8_t i=0; i < _prgPageNum; i++) {
-    status = TFlash.erasePage(FLASH_START_ADDRESS + _pageSize*(_topPrgPageNo + prgNo * _prgPageNum + i));
-    if (status != TFLASH_COMPLETE) {
-      // フラッシュメモリ消去エラー
-      rc = ERR_SYS;
-      break;
-    };
-  }
-  
-  //  書き込みロック
-  TFlash.lock();        
-  return rc;
-}
-
 // 仮想EEPROMから指定アドレスのデータ読み込み
 // 引数
 //  address  : アドレス
@@ -225,13 +348,499 @@ uint8_t tFlashMan::EEPFormat() {
   return rc;
 }
 
+// 指定範囲の消去状態のチェック
+// 引数
+//  ofs  :領域先頭からのオフセット(偶数)
+//  len  :バイト数
+// 戻り値
+//  1:消去状態 0:書込み済みの箇所あり
+uint8_t tFlashMan::isBlank(uint16_t ofs, uint16_t len) {
+  uint16_t* pw = (uint16_t*)(uintptr_t)(_areaTop + ofs);
+  for (len = (len + 1) / 2; len; len--)
+    if (*pw++ != 0xffff)
+      return 0;
+  return 1;
+}
+
+// 指定ページの消去
+// 引数
+//  pg   :領域内のページ番号
+// 戻り値
+//  0:正常終了 0以外異常
+// 消去済みのページは消去しない
+uint8_t tFlashMan::erasePage(uint16_t pg) {
+  TFLASH_Status status;
+  uint16_t cnt = 0;
+  if (isBlank(pg * _pageSize, _pageSize))
+    return 0;
+  TFlash.unlock();
+  status = TFlash.erasePage(_areaTop + (uint32_t)pg * _pageSize);
+  TFlash.lock();
+  if (status != TFLASH_COMPLETE)
+    return 1;
+
+  // 消去回数の記録(記録の失敗は消去の結果に含めない)
+  EEPRead(CONFIG_WEAR + pg, &cnt);
+  if (cnt != 0xffff)
+    EEPWrite(CONFIG_WEAR + pg, cnt + 1);
+  return 0;
+}
+
+// 指定ページの消去回数の取得
+// 引数
+//  pg   :領域内のページ番号
+// 戻り値
+//  消去回数(記録なしの場合は0)
+uint16_t tFlashMan::getEraseCount(uint16_t pg) {
+  uint16_t cnt = 0;
+  if (pg >= _areaPageNum || EEPRead(CONFIG_WEAR + pg, &cnt))
+    return 0;
+  return cnt;
+}
+
+// 指定位置のレコードヘッダの有効性チェック
+// 引数
+//  ofs  :領域先頭からのオフセット
+// 戻り値
+//  1:有効 0:無効
+uint8_t tFlashMan::isValidRec(uint16_t ofs) {
+  PrgRecHeader* h = recAt(ofs);
+  if (ofs + PRGREC_HDR_SIZE > _areaSize || h->magic != PRGREC_MAGIC)
+    return 0;
+  if (h->hcrc != crc16((uint8_t*)h, PRGREC_HDR_SIZE - 4))
+    return 0;
+  if (!(h->flags & PRGREC_FLG_WRAP) && ofs + recSize(h->storeLen) > _areaSize)
+    return 0;
+  return 1;
+}
+
+// 次のレコード位置の取得
+// 引数
+//  ofs  :領域先頭からのオフセット
+// 戻り値
+//  次のレコードの位置
+// 無効なヘッダ(書込み中の電源断など)の場合は次のページの先頭とする
+uint16_t tFlashMan::nextRec(uint16_t ofs) {
+  if (!isValidRec(ofs))
+    ofs = (ofs / _pageSize + 1) * _pageSize;
+  else if (recAt(ofs)->flags & PRGREC_FLG_WRAP)
+    ofs = 0;
+  else
+    ofs += recSize(recAt(ofs)->storeLen);
+  if (ofs + PRGREC_HDR_SIZE > _areaSize)
+    ofs = 0;
+  return ofs;
+}
+
+// 書込み位置に指定サイズのレコードを置けるかのチェック
+// 引数
+//  size    :レコードの占有バイト数
+//  reserve :書込み後に残す空きバイト数
+// 戻り値
+//  1:可 0:不可
+// 書込み後も、書込み位置と最古のレコードのページの間に消去済みのページが1ページ以上残ること
+uint8_t tFlashMan::hasRoom(uint16_t size, uint16_t reserve) {
+  uint16_t top = _tail - _tail % _pageSize;                 // 最古のレコードのページ先頭
+  uint32_t used = (_head + _areaSize - top) % _areaSize;    // 使用済みのバイト数
+  if ((uint32_t)_head + size > _areaSize)
+    used += _areaSize - _head;                              // 領域末尾の折り返し分
+  used += (uint32_t)size + reserve;
+  return (used + _pageSize - 1) / _pageSize + 1 <= _areaPageNum;
+}
+
+// 最新版のレコードの合計サイズ
+// 引数
+//  pMax :最大のレコードの占有バイト数格納アドレス
+// 戻り値
+//  合計バイト数
+uint16_t tFlashMan::liveSize(uint16_t* pMax) {
+  uint16_t size = 0, n;
+  *pMax = 0;
+  for (uint8_t i = 0; i < _maxPrgNum; i++) {
+    if (_dir[i] != PRGREC_NONE) {
+      n = recSize(recAt(_dir[i])->storeLen);
+      size += n;
+      if (n > *pMax)
+        *pMax = n;
+    }
+  }
+  return size;
+}
+
+// レコードのデータの展開・照合
+// 引数
+//  ofs  :領域先頭からのオフセット
+//  dst  :展開先(照合時は照合対象)
+//  len  :展開するバイト数(プログラム長以下)
+//  cmp  :0:展開 1:照合
+// 戻り値
+//  展開(照合一致)したバイト数
+uint16_t tFlashMan::unpackRec(uint16_t ofs, uint8_t* dst, uint16_t len, uint8_t cmp) {
+  PrgRecHeader* h = recAt(ofs);
+  if (h->flags & PRGREC_FLG_LZ)
+    return lzUnpack((uint8_t*)(h + 1), h->storeLen, dst, len, cmp);
+  if (!cmp)
+    memcpy(dst, h + 1, len);
+  else if (memcmp(dst, h + 1, len))
+    return 0;
+  return len;
+}
+
+// レコードの書込み
+// 引数
+//  hdr   :ヘッダ(id、flags、seq、rawLen、storeLen、crcを設定済みのこと)
+//  data  :格納データ(pack=1の場合は圧縮前のデータ)
+//  pack  :1:dataを圧縮しながら書き込む 0:dataをそのまま書き込む
+//  pOfs  :書込み位置格納アドレス
+// 戻り値
+//  0:正常終了 0以外異常
+// (メモ)
+//  ヘッダ(確定以外)、データの順に書き込んで照合し、最後に確定を書き込む。
+//  途中で電源断があっても、確定のないレコードは起動時の走査で無視される。
+//  書込み先が消去状態でない場合(電源断の残骸)は、書込み位置を次のページに進めて異常終了とする
+uint8_t tFlashMan::writeRec(PrgRecHeader& hdr, uint8_t* data, uint8_t pack, uint16_t* pOfs) {
+  PrgRecHeader wrap;
+  PrgRecHeader* h;
+  TFLASH_Status status = TFLASH_COMPLETE;
+  uint16_t ofs = _head;
+  uint16_t size = recSize(hdr.storeLen);
+
+  hdr.magic  = wrap.magic  = PRGREC_MAGIC;
+  hdr.commit = wrap.commit = PRGREC_COMMIT;
+  TFlash.unlock();
+
+  // 領域末尾に収まらない場合は折り返しを記録して先頭から書き込む
+  // (読み飛ばすページは先頭に0を書き、起動時の走査で消去済みページと区別できるようにする)
+  if ((uint32_t)ofs + size > _areaSize) {
+    for (uint16_t pg = ofs / _pageSize + 1; status == TFLASH_COMPLETE && pg < _areaPageNum; pg++)
+      if (isBlank(pg * _pageSize, _pageSize))
+        status = TFlash.write((uint16_t*)recAt(pg * _pageSize), 0);
+    if (status == TFLASH_COMPLETE && ofs + PRGREC_HDR_SIZE <= _areaSize && isBlank(ofs, PRGREC_HDR_SIZE)) {
+      wrap.id = 0xff;  wrap.flags = PRGREC_FLG_WRAP;  wrap.seq = hdr.seq;
+      wrap.rawLen = wrap.storeLen = 0;  wrap.crc = 0xffff;
+      wrap.hcrc = crc16((uint8_t*)&wrap, PRGREC_HDR_SIZE - 4);
+      status = TFlash.write((uint16_t*)recAt(ofs), (uint8_t*)&wrap, PRGREC_HDR_SIZE);
+    }
+    ofs = 0;
+  }
+
+  if (status == TFLASH_COMPLETE && !isBlank(ofs, size)) {
+    TFlash.lock();
+    _head = (ofs / _pageSize + 1) * _pageSize;
+    if (_head + PRGREC_HDR_SIZE > _areaSize)
+      _head = 0;
+    return 1;
+  }
+
+  // ヘッダ(確定を除く)、データの書込み
+  hdr.hcrc = crc16((uint8_t*)&hdr, PRGREC_HDR_SIZE - 4);
+  h = recAt(ofs);
+  if (status == TFLASH_COMPLETE)
+    status = TFlash.write((uint16_t*)h, (uint8_t*)&hdr, PRGREC_HDR_SIZE - 2);
+  if (status == TFLASH_COMPLETE && hdr.storeLen) {
+    if (pack) {
+      LzOut o = { (uint16_t*)(h + 1), 0, 0xffff, 0, TFLASH_COMPLETE };
+      lzPack(data, hdr.rawLen, &o);
+      status = o.status;
+    } else {
+      status = TFlash.write((uint16_t*)(h + 1), data, hdr.storeLen);
+    }
+  }
+  _head = nextRec(ofs);
+
+  // 照合後に確定(圧縮時は格納データのCRCと、展開結果を元のデータと照合する)
+  if (status == TFLASH_COMPLETE && isValidRec(ofs) &&
+      (pack ? h->crc == crc16((uint8_t*)(h + 1), h->storeLen) && unpackRec(ofs, data, hdr.rawLen, 1) == hdr.rawLen
+            : !hdr.storeLen || !memcmp(h + 1, data, hdr.storeLen)))
+    status = TFlash.write(&h->commit, PRGREC_COMMIT);
+  else
+    status = TFLASH_ERROR_PG;
+  TFlash.lock();
+  if (status != TFLASH_COMPLETE || h->commit != PRGREC_COMMIT)
+    return 1;
+  *pOfs = ofs;
+  return 0;
+}
+
+// 最古のレコード位置の移動
+// 引数
+//  next :新しい最古のレコード位置
+// 最古のレコードより前になったページを消去する
+void tFlashMan::moveTail(uint16_t next) {
+  uint16_t pg = _tail / _pageSize;
+  while (pg != next / _pageSize) {
+    erasePage(pg);
+    pg = (pg + 1) % _areaPageNum;
+  }
+  _tail = next;
+}
+
+// 最古のレコードの整理(GC 1レコード分)
+// 戻り値
+//  0:正常終了 0以外異常(整理するレコードなし、書込み失敗)
+// 最新版のレコードは書込み位置に書き直し、削除の記録はそれより古い版がもう無いため捨てる
+uint8_t tFlashMan::collect() {
+  PrgRecHeader* h = recAt(_tail);
+  PrgRecHeader hdr;
+  uint16_t ofs;
+
+  if (_tail == _head)
+    return 1;
+  if (isValidRec(_tail) && !(h->flags & PRGREC_FLG_WRAP) && h->id < _maxPrgNum && _dir[h->id] == _tail) {
+    if (h->flags & PRGREC_FLG_DEL) {
+      _dir[h->id] = PRGREC_NONE;
+    } else {
+      memcpy(&hdr, h, sizeof(hdr));
+      if (!hasRoom(recSize(h->storeLen), 0) || writeRec(hdr, (uint8_t*)(h + 1), 0, &ofs))
+        return 1;
+      _dir[h->id] = ofs;
+    }
+  }
+  moveTail(nextRec(_tail));
+  return 0;
+}
+
+// 旧形式のスロットのプログラム長の取得
+// 引数
+//  prgNo  :プログラム番号
+// 戻り値
+//  プログラム長(バイト)、0:保存なし(旧形式のプログラムでない)
+// スロット末尾のプログラム長が範囲内で、行([1行のバイト長 2バイト][行番号 2バイト][命令文])を
+// たどってちょうどプログラム長で終わる場合を旧形式のプログラムとする
+uint16_t tFlashMan::legacyLen(uint8_t prgNo) {
+  uint16_t slotSize = _prgPageNum * _pageSize;
+  uint8_t* p;
+  uint16_t len, ofs, n;
+
+  if (prgNo >= _maxPrgNum || (uint32_t)(prgNo + 1) * _prgPageNum > _areaPageNum)
+    return 0;
+  p = (uint8_t*)(uintptr_t)(_areaTop + (uint32_t)prgNo * slotSize);
+  len = p[slotSize - 2] | (p[slotSize - 1] << 8);
+  if (!len || len > slotSize - 2)
+    return 0;
+  for (ofs = 0; ofs < len; ofs += n) {
+    n = p[ofs] | (p[ofs + 1] << 8);
+    if (n <= 4 || n > len - ofs)
+      return 0;
+  }
+  return len;
+}
+
+// プログラム保存領域の走査
+// 戻り値
+//  0:正常終了 0以外異常
+// (メモ)
+//  消去済みページの直後のページから有効なレコードを探し、そこから書込み位置までのレコードを順にたどる。
+//  同じプログラム番号は後のレコードを最新版とし、確定のないもの、CRCが一致しないものは無視する。
+//  確定のない最後のレコード(書込み中の電源断)は、その範囲を消去して書込み位置を戻す。
+//  レコードの範囲外に残るページ(GC中の電源断などの残骸)は消去する。
+//  有効なレコードがなく、旧形式のプログラムがある場合は何も消去せず、旧形式のまま読出しのみとする
+uint8_t tFlashMan::scanPrgArea() {
+  PrgRecHeader* h;
+  uint16_t pg, top = PRGREC_NONE;
+  uint16_t ofs = PRGREC_NONE;
+  uint16_t next, torn = PRGREC_NONE;
+  uint16_t n = 0;
+
+  _head = _tail = 0;
+  _seq = 0;
+  _legacy = 0;
+  for (uint8_t i = 0; i < FLASH_PRG_MAX; i++)
+    _dir[i] = PRGREC_NONE;
+
+  // 最古のレコードのページ(直前が消去済みのページ)
+  for (pg = 0; pg < _areaPageNum; pg++) {
+    if (!isBlank(pg * _pageSize, _pageSize) && isBlank(((pg + _areaPageNum - 1) % _areaPageNum) * _pageSize, _pageSize)) {
+      top = pg;
+      break;
+    }
+  }
+
+  // 最古のレコード(ページ内の最初の有効なヘッダ)
+  if (top != PRGREC_NONE) {
+    for (pg = top; ofs == PRGREC_NONE && !isBlank(pg * _pageSize, _pageSize); pg = (pg + 1) % _areaPageNum) {
+      for (uint16_t i = 0; i < _pageSize; i += 2) {
+        if (isValidRec(pg * _pageSize + i)) {
+          ofs = pg * _pageSize + i;
+          break;
+        }
+      }
+      if ((pg + 1) % _areaPageNum == top)
+        break;
+    }
+  }
+
+  if (ofs != PRGREC_NONE) {
+    // レコードを書込み位置までたどる
+    _tail = ofs;
+    for (uint16_t i = 0; i < _areaSize / PRGREC_HDR_SIZE && !isBlank(ofs, PRGREC_HDR_SIZE); i++) {
+      h = recAt(ofs);
+      next = nextRec(ofs);
+      torn = PRGREC_NONE;
+      if (isValidRec(ofs) && !(h->flags & PRGREC_FLG_WRAP)) {
+        if (!n++ || (int16_t)(h->seq - _seq) >= 0)
+          _seq = h->seq + 1;
+        if (h->commit == PRGREC_COMMIT && h->id < _maxPrgNum && h->crc == crc16((uint8_t*)(h + 1), h->storeLen))
+          _dir[h->id] = ofs;
+        if (h->commit != PRGREC_COMMIT) {
+          if (isBlank(next, PRGREC_HDR_SIZE)) {
+            torn = ofs;  // 最後のレコード(書込み中の電源断)
+          } else {
+            // 途中のレコードの範囲内に残る消去済みページは先頭に0を書く
+            // (最古のレコードの探索で書込み位置と最古のレコードの間の消去済みページと誤認しないため)
+            for (pg = ofs / _pageSize + 1; (uint32_t)pg * _pageSize < ofs + recSize(h->storeLen); pg++)
+              if (isBlank(pg * _pageSize, _pageSize))
+                write(_areaTop + (uint32_t)pg * _pageSize, 0);
+          }
+        }
+      }
+      ofs = next;
+    }
+    _head = ofs;
+
+    // 確定のない最後のレコードの範囲を後ろのページから消去し、書込み位置を戻す
+    // (電源断のたびに空きが減り、GCで最新版を書き直せなくなることを防ぐ。
+    //  ヘッダがページの途中にある場合はヘッダを無効(0)にして次のページから書き込む)
+    if (torn != PRGREC_NONE) {
+      for (pg = (torn + recSize(recAt(torn)->storeLen) - 1) / _pageSize; pg > torn / _pageSize; pg--)
+        if (erasePage(pg))
+          return 1;
+      if (torn % _pageSize) {
+        write(_areaTop + torn, 0);
+        _head = nextRec(torn);
+      } else {
+        if (erasePage(torn / _pageSize))
+          return 1;
+        _head = torn;
+      }
+    }
+    pg = (_head + _pageSize - 1) / _pageSize % _areaPageNum;
+  } else {
+    // 旧形式のプログラムあり(format()まで消去しない)
+    for (uint8_t i = 0; i < _maxPrgNum; i++) {
+      if (legacyLen(i)) {
+        _legacy = 1;
+        return 0;
+      }
+    }
+    // 有効なレコードなし(全ページを消去し、消去回数の最も少ないページから書き始める)
+    for (pg = 0; pg < _areaPageNum; pg++) {
+      if (erasePage(pg))
+        return 1;
+      if (getEraseCount(pg) < getEraseCount(_tail / _pageSize))
+        _head = _tail = pg * _pageSize;
+    }
+    pg = _tail / _pageSize;
+  }
+
+  // 書込み位置の次のページから最古のレコードのページの前までを消去状態にする
+  while (pg != _tail / _pageSize) {
+    if (erasePage(pg))
+      return 1;
+    pg = (pg + 1) % _areaPageNum;
+  }
+  return 0;
+}
+
+// プログラム保存領域のフォーマット
+// 戻り値
+//  0:正常終了 0以外異常
+// 全ページを消去し(消去済みのページは除く)、空の保存領域として走査し直す
+uint8_t tFlashMan::format() {
+  for (uint16_t pg = 0; pg < _areaPageNum; pg++)
+    if (erasePage(pg))
+      return 1;
+  return scanPrgArea();
+}
+
 // 指定プログラム 格納先頭アドレスの取得
 // 引数
 //  prgNo  :プログラム番号
 // 戻り値
-//  格納先頭アドレスの取得
+//  格納先頭アドレス(最新版のレコードのデータ)、NULL:保存なし、圧縮格納(直接参照不可)
 uint8_t* tFlashMan::getPrgAddress(uint8_t prgNo) {
-  return (uint8_t*)(FLASH_START_ADDRESS + (uint32_t)(_topPrgPageNo+prgNo*_prgPageNum) * (uint32_t)_pageSize); 
+  if (_legacy)
+    return legacyLen(prgNo) ? (uint8_t*)(uintptr_t)(_areaTop + (uint32_t)prgNo * _prgPageNum * _pageSize) : NULL;
+  if (!isExistPrg(prgNo) || (recAt(_dir[prgNo])->flags & PRGREC_FLG_LZ))
+    return NULL;
+  return (uint8_t*)(recAt(_dir[prgNo]) + 1);
+}
+
+// 指定プログラムの先頭部分の読込み
+// 引数
+//  prgNo  :プログラム番号
+//  buf    :読込み先
+//  len    :読込みバイト数
+// 戻り値
+//  読み込んだバイト数(プログラム長がlenより短い場合はプログラム長)、0:保存なし
+// 圧縮格納の場合も先頭からlenバイト分だけを展開する
+uint16_t tFlashMan::readPrg(uint8_t prgNo, uint8_t* buf, uint16_t len) {
+  if (!isExistPrg(prgNo))
+    return 0;
+  if (_legacy) {
+    if (len > legacyLen(prgNo))
+      len = legacyLen(prgNo);
+    memcpy(buf, getPrgAddress(prgNo), len);
+    return len;
+  }
+  if (len > recAt(_dir[prgNo])->rawLen)
+    len = recAt(_dir[prgNo])->rawLen;
+  return unpackRec(_dir[prgNo], buf, len, 0);
+}
+
+// 指定プログラムのプログラム長の取得
+// 引数
+//  prgNo  :プログラム番号
+// 戻り値
+//  プログラム長(バイト)、0:保存なし
+uint16_t tFlashMan::getPrgSize(uint8_t prgNo) {
+  if (_legacy)
+    return legacyLen(prgNo);
+  if (!isExistPrg(prgNo))
+    return 0;
+  return recAt(_dir[prgNo])->rawLen;
+}
+
+// レコードの保存
+// 引数
+//  hdr     :ヘッダ(id、flags、rawLen、storeLen、crcを設定済みのこと)
+//  data    :格納データ(pack=1の場合は圧縮前のデータ)
+//  pack    :1:dataを圧縮しながら書き込む 0:dataをそのまま書き込む
+// 戻り値
+//  0:正常終了 ERR_FLASH_FULL:空き領域不足 その他:書込み失敗
+// (メモ)
+//  GCで最新版のレコードを書き直すには、そのレコード分と領域末尾の折り返しの無駄(最大で1レコード分)の
+//  空きが要る。書込み後も最大のレコードの2倍 + 1ページの空きを残し、これを確保できない保存は行わない
+//  削除は最新版の合計を減らすため、削除後の合計で判定する(空き不足で削除もできなくなることを防ぐ)
+uint8_t tFlashMan::saveRecord(PrgRecHeader& hdr, uint8_t* data, uint8_t pack) {
+  uint16_t size = recSize(hdr.storeLen);
+  uint16_t ofs;
+  uint16_t n, max;
+  uint16_t reserve;
+
+  n = liveSize(&max);
+  if ((hdr.flags & PRGREC_FLG_DEL) && _dir[hdr.id] != PRGREC_NONE)
+    n -= recSize(recAt(_dir[hdr.id])->storeLen);
+  if (size > max)
+    max = size;
+  reserve = 2 * max + _pageSize;
+  if ((uint32_t)n + size + reserve + max + 2 * _pageSize > _areaSize)
+    return ERR_FLASH_FULL;
+
+  for (n = 0; n < 2; n++) {
+    for (uint16_t i = 0; !hasRoom(size, reserve); i++) {
+      if (i > _areaSize / PRGREC_HDR_SIZE || collect())
+        return ERR_SYS;
+    }
+    hdr.seq = _seq;
+    if (!writeRec(hdr, data, pack, &ofs))
+      break;
+  }
+  if (n == 2)
+    return ERR_SYS;
+  _seq++;
+  _dir[hdr.id] = ofs;
+  return 0;
 }
 
 // 指定プログラムの消去
@@ -239,44 +848,56 @@ uint8_t* tFlashMan::getPrgAddress(uint8_t prgNo) {
 //  prgNo   :プログラム番号
 // 戻り値
 //  0:正常終了 0以外異常
+// 削除の記録(データなしのレコード)を書き込む
 uint8_t tFlashMan::eraseProgram(uint8_t prgNo) {
-  TFLASH_Status status = TFLASH_COMPLETE;
-  TFlash.unlock();
-  uint32_t flash_adr = (uint32_t)getPrgAddress(prgNo); // アドレスの取得  
-    
-  for (uint8_t i = 0; i < _prgPageNum; i++) {
-    status = TFlash.erasePage(flash_adr + _pageSize*i );
-      if (status != TFLASH_COMPLETE) {
-         break;
-      }
-  }
-  TFlash.lock();
-  return status == TFLASH_COMPLETE ? 0:1;
+  PrgRecHeader hdr;
+  if (_legacy)
+    return ERR_FLASH_OLD;
+  if (!isExistPrg(prgNo))
+    return 0;
+  hdr.id = prgNo;  hdr.flags = PRGREC_FLG_DEL;
+  hdr.rawLen = hdr.storeLen = 0;  hdr.crc = 0xffff;
+  return saveRecord(hdr, NULL, 0);
 }
 
-
 // 指定プログラムの保存
 // 引数
 //  prgNo   :プログラム番号
 //  prgData :プログラム格納アドレス
+//  len     :プログラム長(バイト)
+//  pack    :1:LZ圧縮する 0:圧縮しない
 // 戻り値
-//  0:正常終了 0以外異常
-uint8_t tFlashMan::saveProgram(uint8_t prgNo, uint8_t* prgData) {
-  TFLASH_Status status;
-  uint32_t flash_adr = (uint32_t)getPrgAddress(prgNo);
-  
-  // フラッシュメモリ消去
-  if (eraseProgram(prgNo)) 
-    return 1;
-  
-  // 内部フラッシュメモリへの保存
-  TFlash.unlock();
-  for (uint8_t i = 0; i < _prgPageNum; i++) {
-    status = TFlash.write((uint16_t*)flash_adr, prgData + _pageSize * i, _pageSize);
-    flash_adr += _pageSize;
+//  0:正常終了 ERR_FLASH_FULL:空き領域不足 ERR_FLASH_OLD:旧形式の保存領域 その他:書込み失敗
+// (メモ)
+//  最新版と内容が同じ場合は書き込まない。プログラム長0の場合は削除する。
+//  圧縮は、圧縮後のバイト数とCRCを求めてから、書込み時にもう一度圧縮してそのままフラッシュメモリに書き込む
+//  (圧縮結果用のバッファを持たない)。圧縮しても小さくならない場合は圧縮しない
+uint8_t tFlashMan::saveProgram(uint8_t prgNo, uint8_t* prgData, uint16_t len, uint8_t pack) {
+  PrgRecHeader hdr;
+  if (_legacy)
+    return ERR_FLASH_OLD;
+  if (prgNo >= _maxPrgNum || len > _prgPageNum * _pageSize)
+    return ERR_SYS;
+  if (!len)
+    return eraseProgram(prgNo);
+  if (isExistPrg(prgNo) && recAt(_dir[prgNo])->rawLen == len && unpackRec(_dir[prgNo], prgData, len, 1) == len)
+    return 0;
+
+  hdr.id = prgNo;  hdr.flags = 0;
+  hdr.rawLen = hdr.storeLen = len;
+  hdr.crc = crc16(prgData, len);
+  if (pack) {
+    LzOut o = { NULL, 0, 0xffff, 0, TFLASH_COMPLETE };
+    lzPack(prgData, len, &o);
+    if (recSize(o.len) < recSize(len)) {
+      hdr.flags = PRGREC_FLG_LZ;
+      hdr.storeLen = o.len;
+      hdr.crc = o.crc;
+    } else {
+      pack = 0;
+    }
   }
-  TFlash.lock();
-  return 0;
+  return saveRecord(hdr, prgData, pack);
 }
 
 // 指定プログラムの有無のチェック
@@ -284,31 +905,33 @@ uint8_t tFlashMan::saveProgram(uint8_t prgNo, uint8_t* prgData) {
 //  prgNo   :プログラム番号
 // 戻り値
 //  1:有り 0 無し
-
 uint8_t tFlashMan::isExistPrg(uint8_t prgNo) {
-  // 指定領域に保存されているかチェックする
-  uint8_t* flash_adr = getPrgAddress(prgNo);
-  if ( *flash_adr == 0xff && *(flash_adr+1) == 0xff)
-    return false;
-  else 
-    return true;
+  if (_legacy)
+    return legacyLen(prgNo) != 0;
+  return prgNo < _maxPrgNum && _dir[prgNo] != PRGREC_NONE && !(recAt(_dir[prgNo])->flags & PRGREC_FLG_DEL);
 }
 
 // 指定プログラムのロード
 // 引数
 //  prgNo   :プログラム番号
 //  prgData :プログラム格納アドレス
+//  pLen    :プログラム長格納アドレス
 // 戻り値
 //  0:正常終了 0以外異常
-uint8_t tFlashMan::loadProgram(uint8_t prgNo, uint8_t* prgData) {
- uint8_t* flash_adr = getPrgAddress(prgNo);
-
+uint8_t tFlashMan::loadProgram(uint8_t prgNo, uint8_t* prgData, uint16_t* pLen) {
   // 指定領域に保存されているかチェックする
   if (!isExistPrg(prgNo)) {
     return ERR_NOPRG;
   }
-  // 現在のプログラムの削除とロード
-  memcpy(prgData , flash_adr, _pageSize * _prgPageNum);
+  // 現在のプログラムの削除とロード(圧縮格納の場合は展開)
+  if (_legacy) {
+    *pLen = legacyLen(prgNo);
+    memcpy(prgData, getPrgAddress(prgNo), *pLen);
+    return 0;
+  }
+  *pLen = recAt(_dir[prgNo])->rawLen;
+  if (unpackRec(_dir[prgNo], prgData, *pLen, 0) != *pLen)
+    return ERR_SYS;
   return 0;
 }
   
@@ -319,6 +942,6 @@ uint8_t tFlashMan::loadProgram(uint8_t prgNo, uint8_t* prgData) {
 void tFlashMan::write(uint32_t flash_adr, uint16_t c) {
   // 内部フラッシュメモリへの保存
   TFlash.unlock();
-  TFlash.write((uint16_t*)flash_adr, c);
+  TFlash.write((uint16_t*)(uintptr_t)flash_adr, c);
   TFlash.lock();
 }
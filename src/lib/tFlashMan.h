@@ -3,6 +3,13 @@
 // 2017/11/07 by たま吉さん
 // 2018/08/18 by たま吉さん,システム設定にNTSC横・縦補正の追加
 // 2018/10/04 by たま吉さん,write()の追加
+// 2026/10/18 saveProgram()、loadProgram()をプログラム長分の差分書込み・読込みに変更
+// 2026/10/18 プログラム保存領域を固定スロットからログ構造(可変長レコード)に変更
+// 2026/10/18 ページ別消去回数の記録、getEraseCount()の追加
+// 2026/10/18 getPrgSize()の追加
+// 2026/10/18 プログラムのLZ圧縮保存、readPrg()の追加
+// 2026/10/18 旧形式(固定スロット)の保存領域は消去せず読出しのみとする、format()の追加
+// 2026/10/18 recAt()のポインタへの変換をuintptr_t経由に変更
 //
 
 #ifndef __tFlashMan_h__
@@ -19,6 +26,46 @@
 #define CONFIG_PRG       65532  // 自動起動設定
 #define CONFIG_NTSC_HPOS 65531  // EEPROM NTSC横位置補正
 #define CONFIG_NTSC_VPOS 65530  // EEPROM NTSC縦位置補正
+#define CONFIG_WEAR      0x1000 // EEPROM プログラム保存領域のページ別消去回数(+領域内のページ番号)
+
+// *** プログラム保存領域(ログ構造) **************
+// 保存領域の先頭から可変長のレコードを順に追記し、領域末尾で先頭に折り返す。
+// 最古のレコードのページから、最新版のレコードだけを末尾に書き直してページを消去する(GC)。
+// 書込み位置と最古のレコードの間には常に消去済みのページを1ページ以上残す。
+// ページは一周ごとに順に1回ずつ消去されるため、同じ番号への保存を繰り返しても消去は全ページに分散する。
+#define FLASH_PRG_MAX     16      // 保存プログラム数の上限
+#define PRGREC_MAGIC      0x5442  // レコード識別子('TB')
+#define PRGREC_HDR_SIZE   16      // レコードヘッダのバイト数
+#define PRGREC_FLG_DEL    0x01    // 削除の記録(tombstone)
+#define PRGREC_FLG_WRAP   0x02    // 領域末尾の折り返し
+#define PRGREC_FLG_LZ     0x04    // 格納データのLZ圧縮
+#define PRGREC_COMMIT     0x0000  // 書込み確定
+#define PRGREC_NONE       0xFFFF  // レコードなし
+
+// *** 旧形式のプログラム保存領域(固定スロット) **************
+// 1プログラム当たりの最大ページ数ごとのスロットにmem[]全体を保存し、スロット末尾の2バイトにプログラム長を置く。
+// 起動時に旧形式のプログラムが見つかった場合は領域を消去せず、format()までは読出しのみとする
+
+// *** プログラムのLZ圧縮(LZSS) **************
+// 8項目ごとに先頭にフラグ1バイト(ビット0から順に 1:リテラル1バイト 0:一致2バイト)を置く。
+// 一致は [距離下位8ビット][距離上位4ビット<<4 | 長さ-3] で、直前のデータの複写を表す。
+// 参照窓は元データ(保存時はmem[]、展開時は展開先)そのものを使い、作業用のバッファを持たない
+#define PRG_LZ_WINDOW     1024    // 参照窓のバイト数(最大4095)
+#define PRG_LZ_MINLEN     3       // 一致の最小長
+#define PRG_LZ_MAXLEN     18      // 一致の最大長
+
+// プログラム保存レコードのヘッダ(この後に格納データが続く)
+typedef struct {
+  uint16_t magic;     // レコード識別子
+  uint8_t  id;        // プログラム番号
+  uint8_t  flags;     // フラグ
+  uint16_t seq;       // 書込み通番
+  uint16_t rawLen;    // プログラム長
+  uint16_t storeLen;  // 格納データ長
+  uint16_t crc;       // 格納データのCRC16
+  uint16_t hcrc;      // ヘッダ(magic～crc)のCRC16
+  uint16_t commit;    // 書込み確定(PRGREC_COMMIT:確定 0xFFFF:書込み中断)
+} PrgRecHeader;
 
 class tFlashMan {
  private:
@@ -27,21 +74,98 @@ class tFlashMan {
   uint16_t _prgPageNum;    // 1プログラム当たりのページ数
   uint16_t _maxPrgNum;     // プログラム保存可能数
   uint16_t _topPrgPageNo;  // プログラム保存用先頭ページ番号
+  uint16_t _areaPageNum;   // プログラム保存領域のページ数
+  uint32_t _areaTop;       // プログラム保存領域の先頭アドレス
+  uint16_t _areaSize;      // プログラム保存領域のバイト数
+  uint16_t _head;          // 次のレコードの書込み位置(領域先頭からのオフセット)
+  uint16_t _tail;          // 最古のレコードの位置
+  uint16_t _seq;           // 次の書込み通番
+  uint16_t _dir[FLASH_PRG_MAX]; // プログラム番号別の最新レコードの位置
+  uint8_t  _legacy;        // 1:旧形式の保存領域(読出しのみ)
+
+  // レコードヘッダの参照
+  //  ofs 領域先頭からのオフセット
+  PrgRecHeader* recAt(uint16_t ofs)
+    { return (PrgRecHeader*)(uintptr_t)(_areaTop + ofs); };
+
+  // レコードの占有バイト数の取得
+  //  len 格納データ長
+  uint16_t recSize(uint16_t len)
+    { return PRGREC_HDR_SIZE + ((len + 1) & ~1); };
+
+  // 指定範囲の消去状態のチェック
+  //  ofs 領域先頭からのオフセット, len バイト数
+  uint8_t isBlank(uint16_t ofs, uint16_t len);
+
+  // 指定ページの消去(消去済みの場合は何もしない)
+  //  pg 領域内のページ番号
+  uint8_t erasePage(uint16_t pg);
+
+  // 指定位置のレコードヘッダの有効性チェック
+  //  ofs 領域先頭からのオフセット
+  uint8_t isValidRec(uint16_t ofs);
+
+  // 次のレコード位置の取得
+  //  ofs 領域先頭からのオフセット
+  uint16_t nextRec(uint16_t ofs);
+
+  // 書込み位置に指定サイズのレコードを置けるかのチェック
+  //  size レコードの占有バイト数, reserve 書込み後に残す空きバイト数
+  uint8_t hasRoom(uint16_t size, uint16_t reserve);
+
+  // 最新版のレコードの合計サイズ
+  //  pMax 最大のレコードの占有バイト数格納アドレス
+  uint16_t liveSize(uint16_t* pMax);
+
+  // レコードのデータの展開・照合
+  //  ofs 領域先頭からのオフセット, dst 展開先(照合時は照合対象), len 展開するバイト数, cmp 0:展開 1:照合
+  uint16_t unpackRec(uint16_t ofs, uint8_t* dst, uint16_t len, uint8_t cmp);
+
+  // レコードの書込み
+  //  hdr ヘッダ(id～crc), data 格納データ(圧縮時は圧縮前のデータ), pack 1:圧縮しながら書き込む, pOfs 書込み位置格納アドレス
+  uint8_t writeRec(PrgRecHeader& hdr, uint8_t* data, uint8_t pack, uint16_t* pOfs);
+
+  // レコードの保存(空き領域の確保、書込み、一覧の更新)
+  //  hdr ヘッダ(id、flags、rawLen～crc), data 格納データ, pack 1:圧縮しながら書き込む
+  uint8_t saveRecord(PrgRecHeader& hdr, uint8_t* data, uint8_t pack);
+
+  // 最古のレコードの整理(GC 1レコード分)
+  uint8_t collect();
+
+  // 最古のレコード位置の移動(不要になったページの消去)
+  //  next 新しい最古のレコード位置
+  void moveTail(uint16_t next);
+
+  // 旧形式のスロットのプログラム長の取得
+  //  prgNo プログラム番号
+  uint16_t legacyLen(uint8_t prgNo);
  
  public:
 
   // コンストラクタ
   //  totalPageNum 総ページ数, pageSize 1ページ内バイト数,
-  //  maxPrgNum プログラム保存可能数, prgPageNum 1プログラム当たりのページ数
+  //  maxPrgNum プログラム保存可能数, prgPageNum 1プログラム当たりの最大ページ数,
+  //  areaPageNum プログラム保存領域のページ数
   tFlashMan(uint16_t totalPageNum, uint16_t pageSize,
-  uint16_t maxPrgNum, uint16_t prgPageNum )
-  { init(totalPageNum,pageSize,maxPrgNum, prgPageNum); };
+  uint16_t maxPrgNum, uint16_t prgPageNum, uint16_t areaPageNum )
+  { init(totalPageNum,pageSize,maxPrgNum, prgPageNum, areaPageNum); };
    
   // 初期設定
   //  totalPageNum 総ページ数, pageSize 1ページ内バイト数,
-  //  maxPrgNum プログラム保存可能数, prgPageNum 1プログラム当たりのページ数
+  //  maxPrgNum プログラム保存可能数, prgPageNum 1プログラム当たりの最大ページ数,
+  //  areaPageNum プログラム保存領域のページ数
   void init(uint16_t totalPageNum,uint16_t pageSize,
-            uint16_t maxPrgNum,uint16_t prgPageNum) ;  
+            uint16_t maxPrgNum,uint16_t prgPageNum, uint16_t areaPageNum) ;  
+
+  // プログラム保存領域の走査(起動時にレコードの一覧を作成する)
+  uint8_t scanPrgArea();
+
+  // プログラム保存領域のフォーマット(保存プログラムをすべて消去する)
+  uint8_t format();
+
+  // 旧形式の保存領域のチェック(1:旧形式、保存・削除不可)
+  uint8_t isLegacy()
+    {return _legacy; };
   
   // 総ページ数の取得
   uint16_t getTotalPageNum()
@@ -51,13 +175,17 @@ class tFlashMan {
   uint16_t getPageSize()
     {return _pageSize; };
   
-  // １プログラム当たりのページ数の取得
+  // １プログラム当たりの最大ページ数の取得
   uint16_t getPrgPageNum()
     {return _prgPageNum; };
 
-  // 指定プログラムの消去
-  //  prgNo  プログラム番号
-  uint8_t eraceProgram(uint8_t prgNo);
+  // プログラム保存領域のページ数の取得
+  uint16_t getAreaPageNum()
+    {return _areaPageNum; };
+
+  // プログラム保存領域の指定ページの消去回数の取得
+  //  pg 領域内のページ番号
+  uint16_t getEraseCount(uint16_t pg);
 
   // 仮想EEPROMから指定アドレスのデータ読み込み
   //  address アドレス,pData 読み込みデータ格納アドレス
@@ -78,10 +206,18 @@ class tFlashMan {
   // 仮想EEPROMのフォーマット
   uint8_t EEPFormat();         
 
-  // 指定プログラム 格納先頭アドレスの取得
+  // 指定プログラム 格納先頭アドレスの取得(圧縮格納の場合はNULL)
   // prgNo :  プログラム番号
   uint8_t* getPrgAddress(uint8_t prgNo);
 
+  // 指定プログラムの先頭部分の読込み
+  //  prgNo : プログラム番号, buf : 読込み先, len : 読込みバイト数
+  uint16_t readPrg(uint8_t prgNo, uint8_t* buf, uint16_t len);
+
+  // 指定プログラムのプログラム長の取得
+  // prgNo :  プログラム番号
+  uint16_t getPrgSize(uint8_t prgNo);
+
   // 指定プログラムの有無のチェック
   //  prgNo : プログラム番号
   uint8_t isExistPrg(uint8_t prgNo);
@@ -90,13 +226,13 @@ class tFlashMan {
   //  prgNo : プログラム番号
   uint8_t eraseProgram(uint8_t prgNo);
 
-  // 指定プログラムの保存
-  //  prgNo : プログラム番号, prgData : プログラム格納アドレス
-  uint8_t saveProgram(uint8_t prgNo,uint8_t* prgData);
+  // 指定プログラムの保存(最新版として追記する)
+  //  prgNo : プログラム番号, prgData : プログラム格納アドレス, len : プログラム長, pack : 1:LZ圧縮する
+  uint8_t saveProgram(uint8_t prgNo,uint8_t* prgData, uint16_t len, uint8_t pack = 0);
   
   // 指定プログラムのロード
-  //  prgNo : プログラム番号, prgData : プログラム格納アドレス
-  uint8_t loadProgram(uint8_t prgNo,uint8_t* prgData);
+  //  prgNo : プログラム番号, prgData : プログラム格納アドレス, pLen : プログラム長格納アドレス
+  uint8_t loadProgram(uint8_t prgNo,uint8_t* prgData, uint16_t* pLen);
 
 
   // バイトデータ書き込み
@@ -10,9 +10,28 @@
 //  修正日 2018/08/23, 全角文字(SJIS)対応
 //  修正日 2018/08/29 editLine()（全角対応版）の追加
 //  修正日 2018/09/14 edit() [F1]でのクリア時、ホーム戻り追加
+//  修正日 2026/10/18 受信の先行入力バッファ化、中断キー検出をSysTick割り込み側に移動
+//  修正日 2026/10/18 flowCtrl()の追加
+//  修正日 2026/10/18 mcursesへの画面サイズ設定の追加
+//  修正日 2026/10/18 行の再表示を端末表示内容との差分出力に変更
+//  修正日 2026/10/18 initscr()の出力前にフック関数の参照先を設定
+//  修正日 2026/10/18 deleteLine()で上側の行が少ない場合はVRAM表示窓の移動で行う
+//  修正日 2026/10/18 1行内で収まる文字の挿入・削除は端末の文字挿入・削除機能で表示
+//  修正日 2026/10/18 isJMS()を直前の文字境界からの判定に変更(先頭からの走査をしない)
+//  修正日 2026/10/18 文字列の一括出力write()の追加
+//  修正日 2026/10/18 送信バッファによる出力のパケット単位送信、flush()、getTxStat()の追加
+//  修正日 2026/10/18 先行入力バッファの拡大、read()、getRxStat()の追加
+//  修正日 2026/10/18 キー入力を待ちなしの逐次復号に変更、[ESC]単独入力の時間判定、isKeyIn()で待たない
+//  修正日 2026/10/18 VRAM属性面への文字属性の記録、属性を含めた差分再表示
+//  修正日 2026/10/18 writeRaw()の追加
+//  修正日 2026/10/18 [PageDown]、[PageUP]を1画面単位のスクロールに変更
+//  修正日 2026/10/18 [ESC]単独入力(後続データなし)も中断キーとして検出
 
 #include <string.h>
 #include "tTermscreen.h"
+#if defined(__STM32F1__)
+#include <libmaple/systick.h>
+#endif
 
 // http://katsura-kotonoha.sakura.ne.jp/prog/c/tip00010.shtml
 //*********************************************************
@@ -24,46 +43,285 @@
 //*********************************************************
 #define jms1(c) (((0x81<=c)&&(c<=0x9F))||((0xE0<=c)&&(c<=0xFC))) 
 #define jms2(c) ((0x7F!=c)&&(0x40<=c)&&(c<=0xFC))
+//
+// 1バイト目になり得ないバイト(jms1()以外)の次は必ず文字の先頭となるため、
+// str[nPos]の直前から1バイト目になり得るバイトの連続をさかのぼり、その個数の偶奇で判定する。
+// (文字列先頭から調べないため、行末付近の判定でも連続区間の長さ分の処理で済む)
+// ※ str[nPos]より前に'\0'がある場合は、'\0'の次を文字の先頭として判定する
 int isJMS( uint8_t *str, uint16_t nPos ) {
-	int i;
-	int state; // { 0, 1, 2 }
-
-	state = 0;
-	for( i = 0; str[i] != '\0'; i++ )	{
-		if      ( ( state == 0 ) && ( jms1( str[i] ) ) ) state = 1; // 0 -> 1
-		else if ( ( state == 1 ) && ( jms2( str[i] ) ) ) state = 2; // 1 -> 2
-		else if ( ( state == 2 ) && ( jms1( str[i] ) ) ) state = 1; // 2 -> 1
-		else                                             state = 0; // 2 -> 0, その他
-		// str[nPos] での状態を返す。
-		if ( i == nPos ) return state;
-	}
-	return 0;
+	uint16_t i = nPos;
+
+	if ( str[nPos] == '\0' ) return 0;
+	while ( ( i > 0 ) && ( jms1( str[i-1] ) ) ) i--;
+	if ( ( nPos - i ) & 1 )                          // 直前が1バイト目
+		return jms2( str[nPos] ) ? 2 : 0;
+	return jms1( str[nPos] ) ? 1 : 0;
 }//isJMS
 
 //******* mcurses用フック関数の定義(開始)  *****************************************
 static tTermscreen* tsc = NULL;
 
-// シリアル経由1文字出力
+// 先行入力バッファ
+// 受信(Serial.available()、Serial.read())はArduino_rxpoll()でのみ行う。STM32ではSysTick割り込みから
+// 呼び出し、メインの処理側からは受信しない(受信側の操作は常に1か所からとなり、競合しない)
+#define KEYBUF_SIZE  256                     // バッファサイズ(2のべき乗)
+#define KEY_ESC_WAIT  50                     // [ESC]単独判定の待ち時間(ms)
+static volatile uint8_t keybuf[KEYBUF_SIZE]; // 受信データ
+static volatile uint16_t keybuf_wp = 0;      // 書込み位置(割り込み側で更新)
+static volatile uint16_t keybuf_rp = 0;      // 読込み位置
+static volatile uint8_t flgBreak = 0;        // 中断キー検出フラグ(未処理の中断キーあり)
+static volatile uint16_t brkpos = 0;         // 中断キーの次の位置
+static uint8_t prev_rxch = 0;                // 直前の受信文字
+static uint8_t flgEsc = 0;                   // [ESC]単独判定待ち
+static uint16_t escpos = 0;                  // 判定待ちの[ESC]の位置
+static uint32_t esc_tm = 0;                  // 判定待ちの[ESC]の受信時刻
+static volatile uint32_t rx_bytes = 0;       // 受信バイト数(累計)
+static volatile uint32_t rx_overflow = 0;    // バッファ満杯で取り込みを保留した回数(累計)
+static volatile uint16_t rx_peak = 0;        // バッファ滞留バイト数の最大値
+
+#define KEYBUF_USED() ((keybuf_wp - keybuf_rp) & (KEYBUF_SIZE-1))
+
+// 送信バッファ
+// 出力はいったん送信バッファに溜め、USB CDCのパケット(UARTでは連続送信)単位にまとめて送る
+// 送信はメインの処理側でのみ行う(割り込み側からは送信しない)。
+// 送信はドライバのバッファが空くまで(USB、USARTの割り込みによる送出を)待つことがあり、
+// SysTick割り込みの中では待てないため。受信は待たずに取り出すだけのため割り込み側で行う
+#define TXBUF_SIZE   256                     // バッファサイズ(2のべき乗)
+#define TXPKT_SIZE   64                      // 送信単位(USB CDCの1パケット)
+#define TXBUF_WAIT   2                       // 送信単位に満たないデータの最大保留時間(ms)
+static uint8_t  txbuf[TXBUF_SIZE];           // 送信データ
+static uint16_t txbuf_wp = 0;                // 書込み位置
+static uint16_t txbuf_rp = 0;                // 読込み位置
+static uint32_t txbuf_tm = 0;                // 保留データの書込み開始時刻
+static uint32_t tx_queued = 0;               // 送信要求バイト数(累計)
+static uint32_t tx_stalls = 0;               // バッファ満杯による送信待ち回数(累計)
+static uint16_t tx_peak = 0;                 // 送信バッファ滞留バイト数の最大値
+
+#define TXBUF_USED() ((txbuf_wp - txbuf_rp) & (TXBUF_SIZE-1))
+
+// 待ちなしで送信可能なバイト数
+#if defined(__STM32F1__)
+  // USB CDCは送信中のパケットがなければ1パケット分、UARTはドライバの送信バッファに任せる
+  #define TX_ROOM()  ((tsc->getSerialMode() == 0 && Serial.pending()) ? 0 : TXPKT_SIZE)
+#else
+  #define TX_ROOM()  (tsc->getSerialMode() == 1 ? Serial1.availableForWrite() : Serial.availableForWrite())
+#endif
+
+// 送信バッファからlenバイトを送信(バッファ末尾の折り返しで分割)
+static void Arduino_txsend(uint16_t len) {
+  uint16_t n;
+  
+  while (len) {
+    n = TXBUF_SIZE - txbuf_rp;
+    if (n > len)
+      n = len;
+    if (tsc->getSerialMode() == 0)
+       Serial.write(&txbuf[txbuf_rp], n);
+    else if (tsc->getSerialMode() == 1)
+       Serial1.write(&txbuf[txbuf_rp], n);
+    txbuf_rp = (txbuf_rp + n) & (TXBUF_SIZE-1);
+    len -= n;
+  }
+}
+
+// 送信バッファの吐き出し
+// flgAll: 1 全データを送信(送信完了まで待つ)、0 待ちなしで送れる範囲をパケット単位で送信
+static void Arduino_txflush(uint8_t flgAll) {
+  uint16_t used = TXBUF_USED();
+
+  if (flgAll) {
+    Arduino_txsend(used);
+    return;
+  }
+  while (used >= TXPKT_SIZE && TX_ROOM() >= TXPKT_SIZE) {
+    Arduino_txsend(TXPKT_SIZE);
+    used -= TXPKT_SIZE;
+    txbuf_tm = millis();
+  }
+}
+
+// 送信バッファの定期吐き出し
+// 送信単位に満たないデータもTXBUF_WAIT(ms)以上保留していれば送る
+static void Arduino_txpoll() {
+  uint16_t used = TXBUF_USED();
+
+  if (!used)
+    return;
+  Arduino_txflush(0);
+  used = TXBUF_USED();
+  if (used && millis() - txbuf_tm >= TXBUF_WAIT && TX_ROOM() >= used)
+    Arduino_txsend(used);
+}
 
+// 送信バッファへの書込み
+// バッファが満杯の場合のみ、1パケット分の送信完了を待つ
+static void Arduino_txput(const uint8_t* buf, uint16_t len) {
+  uint16_t used, n;
+
+  tx_queued += len;
+  while (len) {
+    used = TXBUF_USED();
+    if (used == TXBUF_SIZE-1) {
+      tx_stalls++;                     // バッファ満杯
+      Arduino_txsend(TXPKT_SIZE);
+      continue;
+    }
+    if (!used)
+      txbuf_tm = millis();
+    n = TXBUF_SIZE-1 - used;           // 空き
+    if (n > TXBUF_SIZE - txbuf_wp)
+      n = TXBUF_SIZE - txbuf_wp;       // 折り返しまで
+    if (n > len)
+      n = len;
+    memcpy(&txbuf[txbuf_wp], buf, n);
+    txbuf_wp = (txbuf_wp + n) & (TXBUF_SIZE-1);
+    buf += n;
+    len -= n;
+    if (used + n > tx_peak)
+      tx_peak = used + n;
+  }
+  if (TXBUF_USED() >= TXPKT_SIZE)
+    Arduino_txflush(0);
+}
+
+// シリアル経由1文字出力
 static void Arduino_putchar(uint8_t c) {
-  if (tsc->getSerialMode() == 0)
-     Serial.write(c);
-  else if (tsc->getSerialMode() == 1)
-     Serial1.write(c);   
+  Arduino_txput(&c, 1);
+}
+
+// シリアル経由文字列出力
+static void Arduino_write(const uint8_t* buf, uint_fast8_t len) {
+  Arduino_txput(buf, len);
+}
+
+// 受信データの先行入力バッファへの取り込み
+// STM32ではSysTick割り込み(1ms周期)から呼び出す
+// [CTRL-C]、[ESC][ESC]を検出した場合は中断キー検出フラグをセットする
+// [ESC]の後にKEY_ESC_WAIT(ms)以上データが続かず、その[ESC]が未読の場合も中断キーとする
+// (エスケープシーケンスは続けて届くため中断キーとしない。キー入力として読まれた[ESC]も中断キーとしない)
+// バッファが満杯の場合は取り込みを保留する(ドライバ側に残し、欠落させない)
+static void Arduino_rxpoll() {
+  int16_t c;
+  uint16_t wp;
+  
+  if (tsc == NULL)
+    return;
+  for (;;) {
+    wp = (keybuf_wp + 1) & (KEYBUF_SIZE-1);
+    if (wp == keybuf_rp) {
+      // バッファ満杯
+      if (tsc->getSerialMode() == 1 ? Serial1.available() : Serial.available())
+        rx_overflow++;
+      break;
+    }
+    if (tsc->getSerialMode() == 1) {
+      if (!Serial1.available())
+        break;
+      c = Serial1.read();
+    } else {
+      if (!Serial.available())
+        break;
+      c = Serial.read();
+    }
+    keybuf[keybuf_wp] = c;
+    flgEsc = 0;
+    if (c == KEY_ESCAPE && prev_rxch != KEY_ESCAPE) {
+      flgEsc = 1;                      // [ESC]単独判定待ち
+      escpos = keybuf_wp;
+      esc_tm = millis();
+    }
+    keybuf_wp = wp;
+    rx_bytes++;
+    if (KEYBUF_USED() > rx_peak)
+      rx_peak = KEYBUF_USED();
+    if (c == KEY_CTRL_C || (c == KEY_ESCAPE && prev_rxch == KEY_ESCAPE)) {
+      brkpos = wp;                     // 中断キー検出
+      flgBreak = 1;
+      prev_rxch = 0;
+    } else {
+      prev_rxch = c;
+    }
+  }
+
+  // [ESC]単独の判定
+  if (flgEsc && millis() - esc_tm >= KEY_ESC_WAIT) {
+    flgEsc = 0;
+    if (((escpos - keybuf_rp) & (KEYBUF_SIZE-1)) < KEYBUF_USED()) {
+      brkpos = (escpos + 1) & (KEYBUF_SIZE-1); // 中断キー検出(未読の[ESC])
+      flgBreak = 1;
+      prev_rxch = 0;
+    }
+  }
 }
 
+// 受信データの取り込み(割り込みを利用しない環境向け)
+#if defined(__STM32F1__)
+  #define RX_POLL()
+#else
+  #define RX_POLL()  Arduino_rxpoll()
+#endif
+
 // シリアル経由1文字入力
 static char Arduino_getchar() {
-  if (tsc->getSerialMode() == 0) {
-    while (!Serial.available());
-    return Serial.read();
-  } else if (tsc->getSerialMode() == 1) {
-    while (!Serial1.available());
-    return Serial1.read();    
-  } else {
-    while (!Serial.available());
-    return Serial.read();    
+  char c;
+  if (keybuf_rp == keybuf_wp)
+    Arduino_txflush(1);                // 入力待ちの前に出力を吐き出す
+  while (keybuf_rp == keybuf_wp)
+    RX_POLL();
+  c = keybuf[keybuf_rp];
+  keybuf_rp = (keybuf_rp + 1) & (KEYBUF_SIZE-1);
+  if (flgBreak && keybuf_rp == brkpos)
+    flgBreak = 0;                      // 中断キーを通常のキー入力として取得した
+  return c;
+}
+
+// シリアル経由文字列入力
+// 受信済みデータを最大nバイト取り出す(受信データがない場合は1バイト受信するまで待つ)
+// 制御コード(TABを除く)を取り出した時点で終了する
+// 戻り値: 取り出したバイト数
+static uint16_t Arduino_read(uint8_t* buf, uint16_t n) {
+  uint16_t len = 0;
+  uint8_t c;
+
+  if (!n)
+    return 0;
+  if (keybuf_rp == keybuf_wp)
+    Arduino_txflush(1);                // 入力待ちの前に出力を吐き出す
+  while (keybuf_rp == keybuf_wp)
+    RX_POLL();
+  do {
+    c = keybuf[keybuf_rp];
+    keybuf_rp = (keybuf_rp + 1) & (KEYBUF_SIZE-1);
+    buf[len++] = c;
+    if (c < ' ' && c != '\t')
+      break;
+    if (keybuf_rp == keybuf_wp)
+      RX_POLL();
+  } while (len < n && keybuf_rp != keybuf_wp);
+  if (flgBreak && keybuf_rp == brkpos)
+    flgBreak = 0;                      // 中断キーを通常の入力として取得した
+  return len;
+}
+
+// キー入力の取得(待ちなし)
+// 受信済みデータを1バイトずつエスケープシーケンスの復号器(mcurses)に渡し、キーが確定したら返す
+// [ESC]の後にKEY_ESC_WAIT(ms)以上データが続かない場合は、[ESC]単独の入力とする
+// 戻り値: キーコード、ERR: 確定したキー入力なし(シーケンスの途中を含む)
+static uint32_t key_tm = 0;                  // シーケンス途中の最終受信時刻
+
+static uint8_t Arduino_getkey() {
+  uint8_t c;
+
+  RX_POLL();
+  while (keybuf_rp != keybuf_wp) {
+    c = ::mcurses_keyin(Arduino_getchar());
+    if (c != ERR)
+      return c;
+    key_tm = millis();
   }
+  if (::mcurses_keypending() && millis() - key_tm >= KEY_ESC_WAIT)
+    return ::mcurses_keytimeout();
+  return ERR;
 }
 //******* mcurses用フック関数の定義(終了)  *****************************************
 
@@ -111,47 +369,151 @@ void tTermscreen::INSLINE(uint8_t l) {
   ::move(pos_y,pos_x);
 }
 
+// 指定位置に1文字挿入表示(端末の挿入モードを利用)
+// 行末の文字は押し出されて消える
+uint8_t tTermscreen::INSCHAR(uint8_t x, uint8_t y, uint8_t c) {
+  ::move(y,x);
+  ::insch(c);
+  ::move(pos_y, pos_x);
+  return 1;
+}
+
+// 指定位置の1文字削除表示(端末の文字削除機能を利用)
+// 行末には空白が入る
+uint8_t tTermscreen::DELCHAR(uint8_t x, uint8_t y) {
+  ::move(y,x);
+  ::delch();
+  ::move(pos_y, pos_x);
+  return 1;
+}
+
 // 依存デバイスの初期化
 // シリアルコンソール mcursesの設定
 void tTermscreen::INIT_DEV() {
   // mcursesの設定
+  serialMode = 0;
+  tsc = this;                              // initscr()から出力するため先に設定
   ::setFunction_putchar(Arduino_putchar);  // 依存関数
   ::setFunction_getchar(Arduino_getchar);  // 依存関数
+  ::setFunction_write(Arduino_write);      // 依存関数
   ::initscr();                             // 依存関数
+  ::resizeterm(height, width);
   ::setscrreg(0,height-1);
-  serialMode = 0;
-  tsc = this;
+
+  // 端末表示内容の写しの設定(確保できない場合は差分表示なし)
+  if (shadow != NULL)
+    free(shadow);
+  shadow = (uint8_t*)malloc(width * height * 2); // 文字・属性
+  ::mcurses_setshadow(shadow);
+#if defined(__STM32F1__)
+  systick_attach_callback(Arduino_rxpoll); // 受信データの取り込みを割り込みで行う
+#endif
+}
+
+// 依存デバイスの終了
+void tTermscreen::END_DEV() {
+  Arduino_txflush(1);
+  ::mcurses_setshadow(NULL);
+  if (shadow != NULL) {
+    free(shadow);
+    shadow = NULL;
+  }
 }
 
 // キー入力チェック
+// エスケープシーケンスの途中や[ESC]単独の判定待ちでも待たずに0を返す
 uint8_t tTermscreen::isKeyIn() {
- if(serialMode == 0) {
-	if (Serial.available())
-       return get_ch();
-    else
-       return 0;
-  } else if (serialMode == 1) {
-	if (Serial1.available())
-       return get_ch();
-    else
-       return 0;
-	}
-  return 0;
+  uint8_t c;
+
+  Arduino_txpoll();
+  c = Arduino_getkey();
+  if (c == ERR)
+    return 0;
+  ::refresh();
+  return c;
+}
+
+// 中断キー入力チェック
+// 中断キーの検出は受信側で行い、ここではフラグのみ参照する
+uint8_t tTermscreen::isBreak() {
+  Arduino_txpoll();
+  RX_POLL();
+  return flgBreak;
+}
+
+// 中断キー検出のクリア
+// 中断キーまでの先行入力は破棄する
+void tTermscreen::clearBreak() {
+  keybuf_rp = brkpos;
+  flgBreak = 0;
+  ::mcurses_keyreset();                // 復号途中のシーケンスも破棄
+}
+
+// 受信フロー制御(XON/XOFF)
+// flg: 1 受信再開(XON)、0 受信停止(XOFF)
+void tTermscreen::flowCtrl(uint8_t flg) {
+  Arduino_putchar(flg ? 0x11 : 0x13);
+  Arduino_txflush(1);
+}
+
+// 文字列の入力
+// 先行入力バッファから最大nバイトをまとめて取り出す(行単位の受信処理向け)
+// 受信データがない場合は1バイト受信するまで待つ、制御コード(TABを除く)の位置で終了する
+// 戻り値: 取り出したバイト数
+uint16_t tTermscreen::read(uint8_t* buf, uint16_t n) {
+  return Arduino_read(buf, n);
+}
+
+// 受信統計の取得
+//  bytes    : 受信バイト数(累計)
+//  overflow : バッファ満杯で取り込みを保留した回数(累計)
+//  peak     : バッファ滞留バイト数の最大値
+void tTermscreen::getRxStat(uint32_t* bytes, uint32_t* overflow, uint16_t* peak) {
+  *bytes    = rx_bytes;
+  *overflow = rx_overflow;
+  *peak     = rx_peak;
+}
+
+// 出力の吐き出し(送信バッファの全データを送信)
+void tTermscreen::flush() {
+  Arduino_txflush(1);
+}
+
+// 表示を介さないデータの送信(機械間通信用)
+// 送信バッファには入れるが、mcursesの画面管理(カーソル位置・表示内容の写し)には反映しない
+//  buf : 送信データ
+//  len : バイト数
+void tTermscreen::writeRaw(const uint8_t* buf, uint16_t len) {
+  Arduino_txput(buf, len);
+}
+
+// 送信統計の取得
+//  queued : 送信要求バイト数(累計)
+//  stalls : 送信バッファ満杯による送信待ち回数(累計)
+//  peak   : 送信バッファ滞留バイト数の最大値
+void tTermscreen::getTxStat(uint32_t* queued, uint32_t* stalls, uint16_t* peak) {
+  *queued = tx_queued;
+  *stalls = tx_stalls;
+  *peak   = tx_peak;
 }
 
 // 文字入力
+// キー入力があるまで待つ(入力待ちの間は出力を吐き出す)
 uint8_t tTermscreen::get_ch() {
-  uint8_t c = getch();
+  uint8_t c;
+
+  ::refresh();
+  while ((c = Arduino_getkey()) == ERR)
+    Arduino_txflush(1);
   return c;
 }
 
 // キー入力チェック(文字参照)
 int16_t tTermscreen::peek_ch() {
- if(serialMode == 0)
-    return Serial.peek();
- if(serialMode == 1)
-    return Serial1.peek();
-  return 0;
+  RX_POLL();
+  if (keybuf_rp == keybuf_wp)
+    return -1;
+  return keybuf[keybuf_rp];
 }
 
 // カーソルの表示/非表示
@@ -173,8 +535,10 @@ void tTermscreen::setColor(uint16_t fc, uint16_t bc) {
   static const uint16_t tbl_bcolor[]  =
      { B_BLACK,B_RED,B_GREEN,B_BROWN,B_BLUE,B_MAGENTA,B_CYAN,B_WHITE,B_YELLOW};
 
-  if ( fc <= 8 && bc <= 8 )
+  if ( fc <= 8 && bc <= 8 ) {
      attrset(tbl_fcolor[fc]|tbl_bcolor[bc]);  // 依存関数
+     curAttr = ::mcurses_attr8(tbl_fcolor[fc]|tbl_bcolor[bc]); // 以降にVRAMへ書き込む文字の属性
+  }
 }
 
 // 文字属性
@@ -182,8 +546,10 @@ void tTermscreen::setAttr(uint16_t attr) {
   static const uint16_t tbl_attr[]  =
     { A_NORMAL, A_UNDERLINE, A_REVERSE, A_BLINK, A_BOLD };
   
-  if ( attr <= 4 )
+  if ( attr <= 4 ) {
      attrset(tbl_attr[attr]);  // 依存関数
+     curAttr = ::mcurses_attr8(tbl_attr[attr]); // 以降にVRAMへ書き込む文字の属性
+  }
 }
 
 
@@ -347,11 +713,17 @@ void tTermscreen::moveLineEnd() {
 }
 
 // 指定行を削除
+// 削除行より上の行が少ない場合は、上側の行を1行下に転送して表示窓を1行進める
 void tTermscreen::deleteLine(uint16_t l) {
   if (l < height-1) {
-    memmove(&VPEEK(0,l), &VPEEK(0,l+1), width*(height-1-l));
+    if (l < height-1-l && screen + width*(height+1) <= vram + width*vramRows) {
+      vmove(screen+width, screen, width*l);
+      screen += width;
+    } else {
+      vmove(&VPEEK(0,l), &VPEEK(0,l+1), width*(height-1-l));
+    }
   }
-  memset(&VPEEK(0,height-1), 0, width);
+  vclear(&VPEEK(0,height-1), width);
   refresh();
 }
 
@@ -374,29 +746,33 @@ void tTermscreen::delete_char() {
   }
     
   while( *top ) { ln++; top++; } // 行端,長さ調査
+  uint8_t clen = 0;               // 削除バイト数
   if (isShiftJIS(*start_adr) && ln>=2) {
-    memmove(start_adr, start_adr + 2, ln-2); // 2文字詰める
-    *(top-1) = 0;
-    *(top-2) = 0;
+    vmove(start_adr, start_adr + 2, ln-2); // 2文字詰める
+    vclear(top-2, 2);
+    clen = 2;
   } else if ( ln >=1 ) {
-    memmove(start_adr, start_adr + 1, ln-1); // 1文字詰める
-    *(top-1) = 0; 
+    vmove(start_adr, start_adr + 1, ln-1); // 1文字詰める
+    vclear(top-1, 1);
+    clen = 1;
   }
 
-  for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
-    refresh_line(pos_y+i);   
+  if (pos_x + ln < width) {
+    // 1行内で収まる場合は、端末の文字削除機能で表示
+    while (clen--)
+      DELCHAR(pos_x, pos_y);
+  } else {
+    for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
+      refresh_line(pos_y+i);   
+  }
   MOVE(pos_y,pos_x);
   return;
 }
 
 // 行の再表示
+// 端末の表示内容と異なる部分(文字または属性)のみを出力する
 void tTermscreen::refresh_line(uint16_t l) {
-  CLEAR_LINE(l);
-  for (uint16_t j = 0; j < width; j++) {
-    if( IS_PRINT( VPEEK(j,l) )) { 
-      WRITE(VPEEK(j,l));
-    }
-  }
+  ::mcurses_updline(l, &VPEEK(0,l), &VATTR(0,l));
 }
 
 // 文字の出力
@@ -406,6 +782,35 @@ void tTermscreen::putch(uint8_t c) {
   movePosNextNewChar();
 }
 
+// 文字列の出力
+// 制御文字以外の連続する文字は、行末までをまとめてVRAMに書込み、端末に出力する
+// 引数
+//  buf : 出力する文字列
+//  len : 文字列長
+void tTermscreen::write(const uint8_t* buf, uint16_t len) {
+  uint16_t n;
+  while (len) {
+    if (*buf < ' ') {
+      putch(*buf++);   // 制御文字は1文字単位
+      len--;
+      continue;
+    }
+    for (n = 1; n < len && buf[n] >= ' ' && pos_x + n < width; n++)
+      ;
+    memcpy(&VPEEK(pos_x, pos_y), buf, n); // VRAMへの書込み
+    memset(&VATTR(pos_x, pos_y), curAttr, n);
+    ::addnstr((const char*)buf, n);        // 依存関数
+    buf += n;
+    len -= n;
+    if (pos_x + n < width) {
+      MOVE(pos_y, pos_x + n);
+    } else {
+      MOVE(pos_y, width-1);               // 行末まで書込んだ場合は次行(最終行ではスクロール)
+      movePosNextNewChar();
+    }
+  }
+}
+
 // 文字の出力（シフトJIS対応)
 void tTermscreen::putwch(uint16_t c) {
   if (c>0xff) { // 2バイト文字
@@ -458,21 +863,31 @@ void tTermscreen::Insert_char(uint16_t c) {
           Insert_newLine(pos_y+(pos_x+ln)/width);
     }
     // 1文字挿入のために1文字分のスペースを確保
-    memmove(start_adr+clen, start_adr, ln);
+    vmove(start_adr+clen, start_adr, ln);
+    memset(start_adr+attrOfs, curAttr, clen);
+    uint8_t flgOneLine = (pos_x + ln + clen < width - clen); // 挿入後も1行内に収まる
     if (clen ==1) {
       *start_adr=c; // 確保したスペースに1文字表示
+      if (flgOneLine)
+        INSCHAR(pos_x, pos_y, c);
       movePosNextNewChar();
 
     } else {
       *start_adr     = (c>>8);   // 確保したスペースに1バイト目
       *(start_adr+1) = c & 0xff; // 確保したスペースに2バイト目
+      if (flgOneLine) {
+        INSCHAR(pos_x, pos_y, c>>8);
+        INSCHAR(pos_x+1, pos_y, c&0xff);
+      }
       movePosNextNewChar();
       movePosNextNewChar();
     }
     
-    // 挿入した行の再表示
-    for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
-       refresh_line(pos_y+i);   
+    // 次の行に続く場合は、挿入した行の再表示
+    if (!flgOneLine) {
+      for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
+         refresh_line(pos_y+i);   
+    }
     MOVE(pos_y,pos_x);
   }
 }
@@ -500,6 +915,7 @@ uint8_t tTermscreen::editLine() {
         
       case KEY_F5:         // [F5],[CTRL_R] 画面更新
         //beep();
+        CLEAR();           // 端末の表示内容を破棄して全体を再表示
         refresh();  break;
 
       case KEY_END:        // [ENDキー] 行の右端移動
@@ -570,7 +986,7 @@ uint8_t tTermscreen::edit() {
         
       case KEY_NPAGE:      // [PageDown] 表示プログラム最終行に移動
         if (pos_x == 0 && pos_y == height-1) {
-          edit_scrollUp();
+          edit_pageNext();
         } else {
           moveBottom();
         }
@@ -578,7 +994,7 @@ uint8_t tTermscreen::edit() {
       
       case KEY_PPAGE:     // [PageUP] 画面(0,0)に移動
         if (pos_x == 0 && pos_y == 0) {
-          edit_scrollDown();
+          edit_pagePrev();
         } else {
           locate(0, 0);
         }  
@@ -586,6 +1002,7 @@ uint8_t tTermscreen::edit() {
         
       case KEY_F5:         // [F5],[CTRL_R] 画面更新
         beep();
+        CLEAR();           // 端末の表示内容を破棄して全体を再表示
         refresh();  break;
 
       case KEY_END:        // [END]キー 行の右端移動
@@ -637,6 +1054,9 @@ uint8_t tTermscreen::edit() {
       case KEY_F8:        // [F8] 行の結合
         margeLine();
         break;
+
+      case KEY_ESCAPE:     // [ESC] 何もしない
+        break;
       
       default:            // その他 可視可能文字は挿入表示
       
@@ -11,6 +11,14 @@
 //  修正日 2018/08/29 editLine()（全角対応版）の追加
 //  修正日 2018/09/14 splitLine()、margeLine() を親クラスtscreenBase実装に移行
 //  修正日 2019/02/8 mcurses.hのパス変更（スケッチのサブフォルダ配置に対応）
+//  修正日 2026/10/18 isBreak()、clearBreak()の追加
+//  修正日 2026/10/18 flowCtrl()の追加
+//  修正日 2026/10/18 端末表示内容の写し(shadow)による差分再表示、END_DEV()の追加
+//  修正日 2026/10/18 INSCHAR()、DELCHAR()の追加
+//  修正日 2026/10/18 write()の追加
+//  修正日 2026/10/18 flush()、getTxStat()の追加
+//  修正日 2026/10/18 read()、getRxStat()の追加
+//  修正日 2026/10/18 writeRaw()の追加
 //
 
 #ifndef __tTermscreen_h__
@@ -25,7 +33,10 @@
 //class tTermscreen : public tscreenBase, public tSerialDev {
 class tTermscreen : public tscreenBase  {
 	protected:
+    uint8_t* shadow;                             // 端末表示内容の写し(mcurses差分表示用)
+
     void INIT_DEV();                             // デバイスの初期化
+    void END_DEV();                              // デバイスの終了
     void MOVE(uint8_t y, uint8_t x);             // キャラクタカーソル移動
     void WRITE(uint8_t x, uint8_t y, uint8_t c); // 文字の表示
     void CLEAR();                                // 画面全消去
@@ -33,6 +44,8 @@ class tTermscreen : public tscreenBase  {
     void SCROLL_UP();                            // スクロールアップ
     void SCROLL_DOWN();                          // スクロールダウン
     void INSLINE(uint8_t l);                     // 指定行に1行挿入(下スクロール)
+    uint8_t INSCHAR(uint8_t x, uint8_t y, uint8_t c); // 指定位置に1文字挿入表示
+    uint8_t DELCHAR(uint8_t x, uint8_t y);       // 指定位置の1文字削除表示
     
   public:
     void beep() {addch(0x07);};                  // BEEP音の発生
@@ -43,6 +56,14 @@ class tTermscreen : public tscreenBase  {
     uint8_t get_ch();                            // 文字の取得
     uint8_t isKeyIn();                           // キー入力チェック
     int16_t peek_ch();                           // キー入力チェック(文字参照)
+    uint8_t isBreak();                           // 中断キー入力チェック
+    void clearBreak();                           // 中断キー検出のクリア
+    void flowCtrl(uint8_t flg);                  // 受信フロー制御(XON/XOFF)
+    uint16_t read(uint8_t* buf, uint16_t n);     // 文字列の入力
+    void getRxStat(uint32_t* bytes, uint32_t* overflow, uint16_t* peak); // 受信統計の取得
+    void flush();                                // 出力の吐き出し
+    void writeRaw(const uint8_t* buf, uint16_t len); // 表示を介さないデータの送信
+    void getTxStat(uint32_t* queued, uint32_t* stalls, uint16_t* peak); // 送信統計の取得
     inline uint8_t getSerialMode()               // シリアルモードの取得
       { return serialMode; };
 
@@ -61,6 +82,7 @@ class tTermscreen : public tscreenBase  {
     void delete_char();                          // 現在のカーソル位置の文字削除(全角対応)
     uint16_t get_wch();                          // 文字の取得（シフトJIS対応)
     void putch(uint8_t c);                       // 文字の出力
+    void write(const uint8_t* buf, uint16_t len); // 文字列の出力
     void putwch(uint16_t c);                     // 文字の出力（シフトJIS対応)
     void Insert_char(uint16_t c);                // 文字の挿入
     uint8_t edit();                              // スクリーン編集
@@ -9,6 +9,13 @@
 // 修正日 2018/08/23, SC_KEY_XXX をKEY_XXXに変更
 // 修正日 2018/08/29 editLine()（半角入力版）の追加
 // 修正日 2018/09/14 子tTermscreenクラスのsplitLine()、margeLine() を本クラス実装に移行
+// 修正日 2026/10/18 スクロール時の行消去出力の削除
+// 修正日 2026/10/18 スクロール、行挿入をVRAM表示窓の移動で行う(全行の転送をしない)
+// 修正日 2026/10/18 1行内で収まる文字の挿入・削除はデバイスの文字挿入・削除機能で表示
+// 修正日 2026/10/18 write()の追加
+// 修正日 2026/10/18 VRAMに文字属性面を追加(文字面と同じ転送・消去を行う)
+// 修正日 2026/10/18 edit_pageNext()、edit_pagePrev()、edit_showPage()の追加(1画面単位のスクロール)
+// 修正日 2026/10/18 外部確保メモリが2面分の表示行数に満たない場合は動的確保に切り替える
 //
 
 #include "tscreenBase.h"
@@ -17,6 +24,10 @@
   int16_t getPrevLineNo(int16_t lineno);
   int16_t getNextLineNo(int16_t lineno);
   char* getLineStr(int16_t lineno);
+  unsigned char* getLinePtr(uint16_t lineno);
+  unsigned char* getNextLinePtr(unsigned char* p);
+  char* getLinePtrStr(unsigned char* p);
+  unsigned char* getPageTopLinePtr(uint16_t lineno, uint16_t width, uint16_t rows);
 #endif
 
 // スクリーンの初期設定
@@ -25,32 +36,42 @@
 //  h      : スクリーン縦文字数
 //  l      : 1行の最大長
 //  extmem : 外部獲得メモリアドレス NULL:なし NULL以外 あり
+//  extsize: 外部獲得メモリサイズ(文字・属性の2面でh行分に満たない場合は動的確保)
 // 戻り値
 //  なし
-void tscreenBase::init(uint16_t w, uint16_t h, uint16_t l,uint8_t* extmem) {
+// スクリーン用バッファは表示に必要なサイズより大きく確保し、余裕行を表示窓の移動に利用する
+// バッファの前半を文字面、後半を同じ大きさの属性面とする
+// 外部確保メモリ(extmem,extsize)が文字・属性の2面でheight行分に満たない場合は、動的に確保する
+void tscreenBase::init(uint16_t w, uint16_t h, uint16_t l,uint8_t* extmem, uint16_t extsize) {
   width   = w;
   height  = h;
   maxllen = l;
   flgCur = 0;
+  curAttr = 0;
   
   // デバイスの初期化
   INIT_DEV();
 
   // 直前の獲得メモリの開放
   if (!flgExtMem) {
-  	if (screen != NULL) {
-      free(screen);
+  	if (vram != NULL) {
+      free(vram);
     }
   }
 
   // スクリーン用バッファ領域の設定
-  if (extmem == NULL) {
+  if (extmem == NULL || extsize / width / 2 < height) {
     flgExtMem = 0;
-    screen = (uint8_t*)malloc( width * height );
+    vramRows = height * 2;
+    vram = (uint8_t*)malloc( width * vramRows * 2 );
   } else {
      flgExtMem = 1;
-  	 screen = extmem;
+     vramRows = extsize / width / 2;
+  	 vram = extmem;
   }
+  screen = vram;
+  attrOfs = width * vramRows;
+  memset(vram, 0, width * vramRows * 2);
   
   cls();
   show_curs(true);  
@@ -68,8 +89,9 @@ void tscreenBase::end() {
 
   // 動的確保したメモリーの開放
   if (!flgExtMem) {
-    if (screen != NULL) {
-      free(screen);
+    if (vram != NULL) {
+      free(vram);
+      vram = NULL;
       screen = NULL;
     }
   }
@@ -77,7 +99,7 @@ void tscreenBase::end() {
 
 // 指定行の1行分クリア
 void tscreenBase::clerLine(uint16_t l) {
-  memset(screen+width*l, 0, width);
+  vclear(screen+width*l, width);
   CLEAR_LINE(l);
   MOVE(pos_y, pos_x);
 }
@@ -85,7 +107,7 @@ void tscreenBase::clerLine(uint16_t l) {
 // スクリーンのクリア
 void tscreenBase::cls() {
   CLEAR();
-  memset(screen, 0, width*height);
+  vclear(screen, width*height);
 }
 
 // スクリーンリフレッシュ表示
@@ -106,29 +128,52 @@ void tscreenBase::refresh_line(uint16_t l) {
 }
 
 // 1行分スクリーンのスクロールアップ
+// スクロールで現れる行はデバイス側で空白になるため、VRAMのみクリアする
+// VRAMは表示窓を1行下にずらす。確保領域の末尾に達した場合のみ表示窓を領域先頭に転送する
+// (表示窓以降の領域は常に0とし、行端の連続性の調査で表示窓の外を文字とみなさないようにする)
 void tscreenBase::scroll_up() {
-  memmove(screen, screen + width, (height-1)*width);
+  if (screen + width*(height+1) <= vram + width*vramRows) {
+    screen += width;
+  } else {
+    vmove(vram, screen + width, (height-1)*width);
+    screen = vram;
+    vclear(screen + width*height, width*(vramRows-height));
+  }
+  vclear(screen + width*(height-1), width);
   draw_cls_curs();
   SCROLL_UP();
-  clerLine(height-1);
   MOVE(pos_y, pos_x);
 }
 
 // 1行分スクリーンのスクロールダウン
+// VRAMは表示窓を1行上にずらす。確保領域の先頭に達した場合のみ表示窓を領域末尾に転送する
 void tscreenBase::scroll_down() {
-  memmove(screen + width, screen, (height-1)*width);
+  if (screen > vram) {
+    screen -= width;
+    vclear(screen + width*height, width);  // 表示窓から外れた行
+  } else {
+    vmove(vram + width*(vramRows-height+1), screen, (height-1)*width);
+    screen = vram + width*(vramRows-height);
+  }
+  vclear(screen, width);
   draw_cls_curs();
   SCROLL_DOWN();
-  clerLine(0);
   MOVE(pos_y, pos_x);
 }
 
 // 指定行に空白行挿入
+// 挿入位置より上の行が少ない場合は、上側の行を1行上に転送して表示窓を1行戻す
 void tscreenBase::Insert_newLine(uint16_t l) {
   if (l < height-1) {
-    memmove(screen+(l+2)*width, screen+(l+1)*width, width*(height-1-l-1));
+    if (l+1 < height-2-l && screen > vram) {
+      vmove(screen-width, screen, width*(l+1));
+      screen -= width;
+      vclear(screen + width*height, width); // 表示窓から外れた行
+    } else {
+      vmove(screen+(l+2)*width, screen+(l+1)*width, width*(height-1-l-1));
+    }
   }
-  memset(screen+(l+1)*width, 0, width);
+  vclear(screen+(l+1)*width, width);
   INSLINE(l+1);
 }
 
@@ -143,11 +188,14 @@ void tscreenBase::delete_char() {
   
   while( *top ) { ln++; top++; } // 行端,長さ調査
   if ( ln > 1 ) {
-    memmove(start_adr, start_adr + 1, ln-1); // 1文字詰める
+    vmove(start_adr, start_adr + 1, ln-1); // 1文字詰める
+  }
+  vclear(top-1, 1); 
+  if (pos_x + ln >= width || !DELCHAR(pos_x, pos_y)) {
+    // 次の行に続く場合は再表示
+    for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
+      refresh_line(pos_y+i);   
   }
-  *(top-1) = 0; 
-  for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
-    refresh_line(pos_y+i);   
   MOVE(pos_y,pos_x);
   return;
 }
@@ -159,6 +207,15 @@ void tscreenBase::putch(uint8_t c) {
  movePosNextNewChar();
 }
 
+// 文字列の出力
+// 引数
+//  buf : 出力する文字列
+//  len : 文字列長
+void tscreenBase::write(const uint8_t* buf, uint16_t len) {
+  while (len--)
+    putch(*buf++);
+}
+
 
 // 現在のカーソル位置に文字を挿入
 void tscreenBase::Insert_char(uint8_t c) {  
@@ -195,13 +252,19 @@ void tscreenBase::Insert_char(uint8_t c) {
           Insert_newLine(pos_y+(pos_x+ln)/width);
     }
     // 1文字挿入のために1文字分のスペースを確保
-    memmove(start_adr+1, start_adr, ln);
+    vmove(start_adr+1, start_adr, ln);
     *start_adr=c; // 確保したスペースに1文字表示
-    movePosNextNewChar();
+    start_adr[attrOfs]=curAttr;
+    if (pos_x + ln + 1 < width - 1 && INSCHAR(pos_x, pos_y, c)) {
+      // 挿入後も1行内に収まる場合は、デバイスの文字挿入機能で表示済み
+      movePosNextNewChar();
+    } else {
+      movePosNextNewChar();
     
-    // 挿入した行の再表示
-    for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
-       refresh_line(pos_y+i);   
+      // 挿入した行の再表示
+      for (uint8_t i=0; i < (pos_x+ln)/width+1; i++)
+         refresh_line(pos_y+i);   
+    }
     MOVE(pos_y,pos_x);
   }
 }
@@ -465,6 +528,83 @@ uint8_t tscreenBase::edit_scrollDown() {
   return 0;
 }
 
+#if DEPEND_TTBASIC == 1
+// 指定行から1画面分のプログラムを表示する
+// 引数
+//  lp : 先頭行へのポインタ
+// 戻り値
+//  なし
+// 画面に収まる行をVRAMに並べてから、まとめて再表示する(端末には差分のみ出力される)
+void tscreenBase::edit_showPage(uint8_t* lp) {
+  char* text;
+  uint16_t len;
+  uint16_t y = 0;
+
+  vclear(screen, width*height);
+  while (lp) {
+    text = getLinePtrStr(lp);
+    len = strlen(text);
+    if (y + len/width + 1 > height)
+      break;
+    memcpy(&VPEEK(0,y), text, len);
+    y += len/width + 1;
+    lp = getNextLinePtr(lp);
+  }
+  draw_cls_curs();
+  refresh();
+}
+#endif
+
+// 編集中画面を1画面分スクロールアップする(次ページの表示)
+// 画面内の最後の行の次の行から1画面分を表示する。
+// 最後の行が画面下端で切れている場合はその行から表示する
+uint8_t tscreenBase::edit_pageNext() {
+#if DEPEND_TTBASIC == 0
+  edit_scrollUp();
+#else
+  int16_t lineno = -1;
+  int16_t l, e;
+  uint8_t* lp;
+
+  for (l = height-1; l >= 0; l--)
+    if ((lineno = getLineNum(l)) > 0)
+      break;
+  if (lineno <= 0)
+    return edit_scrollUp();
+
+  for (e = l; e < height && VPEEK(width-1, e); e++)   // 行の終端位置
+    ;
+  lp = getLinePtr(e < height ? lineno+1 : lineno);
+  if (!lp)
+    return edit_scrollUp();
+  edit_showPage(lp);
+#endif
+  return 0;
+}
+
+// 編集中画面を1画面分スクロールダウンする(前ページの表示)
+// 画面内の最初の行の直前の行までを1画面分表示する
+uint8_t tscreenBase::edit_pagePrev() {
+#if DEPEND_TTBASIC == 0
+  edit_scrollDown();
+#else
+  int16_t lineno = -1;
+  uint8_t* lp;
+
+  for (int16_t l = 0; l < height; l++)
+    if ((lineno = getLineNum(l)) > 0)
+      break;
+  if (lineno <= 0)
+    return edit_scrollDown();
+
+  lp = getPageTopLinePtr(lineno, width, height);
+  if (!lp)
+    return edit_scrollDown();
+  edit_showPage(lp);
+#endif
+  return 0;
+}
+
 // ライン編集（半角入力版）
 // 中断の場合、0を返す
 uint8_t tscreenBase::editLine() {
@@ -557,13 +697,13 @@ void tscreenBase::margeLine() {
   }  
     
   // 行の結合
-  memmove(top, next_start_adr, next_ln);
+  vmove(top, next_start_adr, next_ln);
   
   // 結合元のデータ消去
   if (offset)
-    memset(next_start_adr+next_ln-offset, 0,offset);
+    vclear(next_start_adr+next_ln-offset, offset);
   else
-    memset(next_start_adr, 0,+next_ln);
+    vclear(next_start_adr, next_ln);
   refresh(); 
 }
 
@@ -592,10 +732,10 @@ void tscreenBase::splitLine() {
   }
   
   // 分割行の移動
-  memmove(&VPEEK(0,pos_y+1), start_adr, ln);
+  vmove(&VPEEK(0,pos_y+1), start_adr, ln);
   
   // 移動元の消去
-  memset(start_adr,0,ln);
+  vclear(start_adr, ln);
   
   refresh(); 
 }  
@@ -7,6 +7,16 @@
 // 修正日 2018/08/23 キー文字コードをmcursesの定義に統合
 // 修正日 2018/08/29 editLine()（半角入力版）の追加
 // 修正日 2018/09/14 子tTermscreenクラスのsplitLine()、margeLine() を本クラス実装に移行
+// 修正日 2026/10/18 isBreak()、clearBreak()の追加
+// 修正日 2026/10/18 flowCtrl()の追加
+// 修正日 2026/10/18 VRAMを確保領域内の表示窓とし、スクロールを表示窓の移動で行う
+// 修正日 2026/10/18 INSCHAR()、DELCHAR()の追加
+// 修正日 2026/10/18 write()の追加
+// 修正日 2026/10/18 flush()、getTxStat()の追加
+// 修正日 2026/10/18 read()、getRxStat()の追加
+// 修正日 2026/10/18 VRAMに文字属性面を追加、VATTR()、vmove()、vclear()の追加
+// 修正日 2026/10/18 writeRaw()の追加
+// 修正日 2026/10/18 edit_pageNext()、edit_pagePrev()、edit_showPage()の追加
 
 #ifndef __tscreenBase_h__
 #define __tscreenBase_h__
@@ -17,13 +27,18 @@
 #include "tSerialDev.h"
 #include "mcurses.h"
 
-// VRAM参照マクロ定義
+// VRAM参照マクロ定義(screenは確保領域vram内の表示窓の先頭、属性面は文字面のattrOfsバイト後)
 #define VPEEK(X,Y)      (screen[width*(Y)+(X)])
-#define VPOKE(X,Y,C)    (screen[width*(Y)+(X)]=C)
+#define VPOKE(X,Y,C)    (screen[width*(Y)+(X)]=C,screen[attrOfs+width*(Y)+(X)]=curAttr)
+#define VATTR(X,Y)      (screen[attrOfs+width*(Y)+(X)])
 
 class tscreenBase : public tSerialDev {
   protected:
-    uint8_t* screen;            // スクリーン用バッファ
+    uint8_t* screen;            // スクリーン用バッファ(表示窓の先頭)
+    uint8_t* vram;              // スクリーン用バッファ確保領域
+    uint16_t vramRows;          // スクリーン用バッファ確保領域の行数
+    uint16_t attrOfs;           // 文字面から属性面までのオフセット(width*vramRows)
+    uint8_t curAttr;            // 現在の文字属性(mcurses_attr8()形式 0:標準)
     uint16_t width;             // スクリーン横サイズ
     uint16_t height;            // スクリーン縦サイズ
     uint16_t maxllen;           // 1行最大長さ
@@ -38,6 +53,10 @@ class tscreenBase : public tSerialDev {
 protected:
     virtual void INIT_DEV() = 0;                              // デバイスの初期化
 	  virtual void END_DEV() {};                                // デバイスの終了
+    inline void vmove(uint8_t* dst, uint8_t* src, uint16_t n) // VRAMの転送(文字・属性)
+      { memmove(dst, src, n); memmove(dst+attrOfs, src+attrOfs, n); };
+    inline void vclear(uint8_t* dst, uint16_t n)              // VRAMの消去(文字・属性)
+      { memset(dst, 0, n); memset(dst+attrOfs, curAttr, n); };
     virtual void MOVE(uint8_t y, uint8_t x) = 0;              // キャラクタカーソル移動
     virtual void WRITE(uint8_t x, uint8_t y, uint8_t c) = 0;  // 文字の表示
     virtual void CLEAR() = 0;                                 // 画面全消去
@@ -45,6 +64,10 @@ protected:
     virtual void SCROLL_UP()  = 0;                            // スクロールアップ
     virtual void SCROLL_DOWN() = 0;                           // スクロールダウン
     virtual void INSLINE(uint8_t l) = 0;                      // 指定行に1行挿入(下スクロール)
+    virtual uint8_t INSCHAR(uint8_t x, uint8_t y, uint8_t c)  // 指定位置に1文字挿入表示(0:未対応)
+      { return 0; };
+    virtual uint8_t DELCHAR(uint8_t x, uint8_t y)             // 指定位置の1文字削除表示(0:未対応)
+      { return 0; };
     
   public:
 	  virtual void beep() {};                              // BEEP音の発生
@@ -52,8 +75,24 @@ protected:
     virtual void draw_cls_curs();                        // カーソルの消去
     inline  uint8_t IsCurs() { return flgCur; };         // カーソル表示有無の取得
     virtual void putch(uint8_t c);                       // 文字の出力
+    virtual void write(const uint8_t* buf, uint16_t len); // 文字列の出力
     virtual uint8_t get_ch();                            // 文字の取得
+    virtual uint16_t read(uint8_t* buf, uint16_t n)      // 文字列の取得(1文字単位の既定実装)
+      { if (!n) return 0; buf[0] = get_ch(); return 1; };
     virtual uint8_t isKeyIn();                           // キー入力チェック
+    virtual uint8_t isBreak() {                          // 中断キー入力チェック
+      uint8_t c = isKeyIn();
+      return (c == KEY_CTRL_C || c == KEY_ESCAPE);
+    };
+    virtual void clearBreak() {};                        // 中断キー検出のクリア
+    virtual void flowCtrl(uint8_t flg) {};               // 受信フロー制御(XON/XOFF)
+    virtual void flush() {};                             // 出力の吐き出し
+    virtual void writeRaw(const uint8_t* buf, uint16_t len) // 表示を介さないデータの送信
+      { while (len--) Serial_write(*buf++); };
+    virtual void getTxStat(uint32_t* queued, uint32_t* stalls, uint16_t* peak) // 送信統計の取得
+      { *queued = 0; *stalls = 0; *peak = 0; };
+    virtual void getRxStat(uint32_t* bytes, uint32_t* overflow, uint16_t* peak) // 受信統計の取得
+      { *bytes = 0; *overflow = 0; *peak = 0; };
 	  virtual void setColor(uint16_t fc, uint16_t bc) {};  // 文字色指定
 	  virtual void setAttr(uint16_t attr) {};              // 文字属性
 	  virtual void set_allowCtrl(uint8_t flg) {};          // シリアルからの入力制御許可設定
@@ -63,7 +102,7 @@ protected:
       //return (((ch) >= 32 && (ch) < 0x7F) || ((ch) >= 0xA0)); 
      return ch;
     };
-    void init(uint16_t w=0,uint16_t h=0,uint16_t ln=128, uint8_t* extmem=NULL); // スクリーンの初期設定
+    void init(uint16_t w=0,uint16_t h=0,uint16_t ln=128, uint8_t* extmem=NULL, uint16_t extsize=0); // スクリーンの初期設定
 	  virtual void end();                               // スクリーン利用終了
     void clerLine(uint16_t l);                        // 1行分クリア
     void cls();                                       // スクリーンのクリア
@@ -89,6 +128,9 @@ protected:
     void Insert_newLine(uint16_t l);                  // 指定行に空白挿入 
     uint8_t edit_scrollUp();                          // スクロールして前行の表示
     uint8_t edit_scrollDown();                        // スクロールして次行の表示
+    uint8_t edit_pageNext();                          // 1画面分スクロールして次ページの表示
+    uint8_t edit_pagePrev();                          // 1画面分スクロールして前ページの表示
+    void edit_showPage(uint8_t* lp);                  // 指定行から1画面分のプログラム表示
     uint16_t vpeek(uint16_t x, uint16_t y);           // カーソル位置の文字コード取得
     
     inline uint8_t *getText() { return &text[0]; };   // 確定入力の行データアドレス参照
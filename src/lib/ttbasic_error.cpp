@@ -3,6 +3,8 @@
 // 2017/11/07 by たま吉さん
 // 修正日 2018/08/29 MMLのエラーメッセージ追加
 // 修正日 2018/10/05 Bad addressの追加
+// 修正日 2026/10/18 Flash fullの追加
+// 修正日 2026/10/18 Old flash formatの追加
 //
 
 #include <Arduino.h>
@@ -49,4 +51,6 @@ const char* errmsg[] __FLASH__ = {
   "Not supported",           // 追加
   "Illegal MML",             // V0.86で追加  
   "Bad address",             // V0.86で追加  	
+  "Flash full",              // 追加
+  "Old flash format",        // 追加
 };
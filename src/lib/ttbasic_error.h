@@ -3,6 +3,8 @@
 // 2017/11/07 by たま吉さん
 // 修正日 2018/08/29 ERR_MMLの追加
 // 修正日 2018/10/05 BAD_ADDRESSの追加
+// 修正日 2026/10/18 ERR_FLASH_FULLの追加
+// 修正日 2026/10/18 ERR_FLASH_OLDの追加
 //
 
 #ifndef __ttbasic_error_h__
@@ -44,6 +46,8 @@ enum ErrorInfo {
   ERR_NOT_SUPPORTED,         // 追加 V0.84
   ERR_MML,                   // 追加 V0.86
   ERR_BAD_ADDRESS,           // 追加 V0.86
+  ERR_FLASH_FULL,            // 追加 プログラム保存領域の空き不足
+  ERR_FLASH_OLD,             // 追加 旧形式のプログラム保存領域(保存・削除不可)
 };
 
 extern const char* errmsg[];
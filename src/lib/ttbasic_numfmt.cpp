@@ -0,0 +1,146 @@
+//
+// 豊四季Tiny BASIC for Arduino STM32 数値の文字列変換
+// 2026/10/18 host.cppから分離(ホスト上のテストから利用するため、Arduino環境に依存しない)
+// 2026/10/18 桁数の境界をlog10f()の丸めによらない厳密な値に変更
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__AVR__)
+#include <stdlib.h>
+#endif
+#include "ttbasic_numfmt.h"
+
+// 2桁の数字列(00～99)
+static const char digitPairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// 整数を文字列変換
+// 下位から2桁ずつ表引きで変換する(負の値は'-'を付ける)
+// 引数
+//  num : 変換する値
+//  buf : 格納先(12バイト以上)
+// 戻り値
+//  文字列の長さ
+int host_intToStr(long num, char *buf) {
+  char tmp[12];
+  char *p = tmp + sizeof(tmp);
+  unsigned long u = num < 0 ? 0UL - (unsigned long)num : (unsigned long)num;
+  const char *d;
+  int len;
+
+  while (u >= 100) {
+    d = &digitPairs[(u % 100) * 2];
+    u /= 100;
+    *--p = d[1];
+    *--p = d[0];
+  }
+  if (u >= 10) {
+    d = &digitPairs[u * 2];
+    *--p = d[1];
+    *--p = d[0];
+  } else {
+    *--p = '0' + u;
+  }
+  if (num < 0)
+    *--p = '-';
+  len = tmp + sizeof(tmp) - p;
+  memcpy(buf, p, len);
+  buf[len] = 0;
+  return len;
+}
+
+// フロート型の10進桁数の境界(ビット表現、正の値)
+// 各桁数の開始値は10^k以上の最小のfloat(厳密な比較による値で、log10f()の実装に依存しない)
+// 10^kよりわずかに小さい値は下の桁数となる(例:99.99998は"99.99998"、100にはならない)
+static const uint32_t floatDigitsBound[] = {
+  0x3a83126f, 0x3c23d70b, 0x3dcccccd, 0x3f800000, 0x41200000, // 桁数 -2 .. 2 の開始値
+  0x42c80000, 0x447a0000, 0x461c4000, 0x47c35000, 0x49742400, // 桁数  3 .. 7 の開始値
+};
+#define FLOAT_FIX_MIN  0x38d1b718   // 固定小数点表記の最小値(0.0001以上の最小のfloat)
+#define FLOAT_FIX_MAX  0x49742400   // 固定小数点表記の最大値(1000000)
+
+// 10のべき乗(小数点以下の桁数分の桁上げ用)
+static const uint64_t pow10Tbl[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+  10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+};
+
+// フロート型を文字列変換
+// 0.0001以上1000000以下は有効桁7桁の固定小数点表記(末尾の0は除く)、それ以外は指数表記
+// 固定小数点表記はIEEE754のビット表現から整数演算で変換する
+// (従来のdtostrf()による変換と同じ、10進表記の最近接偶数丸めとなる)
+char *host_floatToStr(float f, char *buf) {
+  union { float f; uint32_t u; } v;
+  uint32_t a, m, n;
+  uint64_t t, r, half;
+  uint8_t  prec, s, i;
+  char tmp[12];
+  char *p = buf;
+
+  v.f = f;
+  a = v.u & 0x7fffffff;
+  if (a == 0) {
+    buf[0] = '0'; 
+    buf[1] = 0;
+  } else if (a < FLOAT_FIX_MIN || a > FLOAT_FIX_MAX) {
+    // this will output -1.123456E99 = 13 characters max including trailing nul
+#if defined(__AVR__) 
+   dtostre(f, buf, 6, 0);
+#else
+   sprintf(buf, "%6.2e", f);
+#endif
+  } else {
+    // 有効桁7桁とする小数点以下の桁数
+    for (i = 0; i < 10 && a >= floatDigitsBound[i]; i++)
+      ;
+    prec = 10 - i;
+
+    // a = m * 2^-s
+    m = (a & 0x7fffff) | 0x800000;
+    s = 150 - (a >> 23);
+    if (s < 24 && !(m & ((1UL << s) - 1))) {
+      // 整数値
+      n = m >> s;
+      prec = 0;
+    } else {
+      // a * 10^prec を整数に丸める(最近接偶数丸め)
+      t = m * pow10Tbl[prec];
+      half = (uint64_t)1 << (s - 1);
+      r = t & ((half << 1) - 1);
+      n = (uint32_t)(t >> s);
+      if (r > half || (r == half && (n & 1)))
+        n++;
+      // remove trailing 0s
+      while (prec && n % 10 == 0) {
+        n /= 10;
+        prec--;
+      }
+    }
+
+    if (v.u & 0x80000000)
+      *p++ = '-';
+    if (!prec) {
+      host_intToStr(n, p);
+      return buf;
+    }
+
+    // 数字列(下位桁から、小数点以下の桁数+1桁以上)
+    i = 0;
+    do {
+      tmp[i++] = '0' + n % 10;
+      n /= 10;
+    } while (n || i <= prec);
+
+    while (i) {
+      if (i == prec)
+        *p++ = '.';
+      *p++ = tmp[--i];
+    }
+    *p = 0;
+  }
+  return buf;
+}
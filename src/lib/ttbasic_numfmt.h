@@ -0,0 +1,19 @@
+//
+// 豊四季Tiny BASIC for Arduino STM32 数値の文字列変換
+// 2026/10/18 host.cppから分離(ホスト上のテストから利用するため、Arduino環境に依存しない)
+//
+
+#ifndef __ttbasic_numfmt_h__
+#define __ttbasic_numfmt_h__
+
+// 整数を文字列変換
+//  num : 変換する値, buf : 格納先(12バイト以上)
+//  戻り値: 文字列の長さ
+int host_intToStr(long num, char *buf);
+
+// フロート型を文字列変換
+//  f : 変換する値, buf : 格納先(14バイト以上)
+//  戻り値: buf
+char *host_floatToStr(float f, char *buf);
+
+#endif
@@ -0,0 +1,53 @@
+//
+// インタプリタのホスト(PC)上の実行(Linux)
+// 2026/10/18 新規作成
+//  入力ファイルの内容をシリアル入力としてスケッチ(setup()、loop())を実行し、端末への出力を標準出力に書き出す
+//  入力を使い切って入力待ちになると終了する
+//
+// ビルド(リポジトリのトップで)
+//  SRCS="test/stub/Arduino.cpp -x c++ arduinoBASIC_STM32.ino -x none basic.cpp host.cpp src/lib/tFlashMan.cpp
+//    src/lib/tSerialDev.cpp src/lib/tTermscreen.cpp src/lib/tscreenBase.cpp src/lib/ttbasic_error.cpp
+//    src/lib/ttbasic_numfmt.cpp -x c src/lib/mcurses.c"     (1行で指定)
+//  g++ -O2 -funsigned-char -fno-rtti -Itest/stub -I. -Isrc/lib -o basic_host test/basic_host.cpp $SRCS
+// 実行
+//  ./basic_host 入力ファイル        (入力ファイル省略時は標準入力、行の区切りはCR)
+//  FLASHIMG=イメージファイル を指定すると、起動時にフラッシュメモリの内容を読み込み、終了時に書き出す
+//
+
+#include <Arduino.h>
+
+void setup();
+void loop();
+
+static const char* img;  // フラッシュメモリのイメージファイル
+
+static void saveImage() {
+  if (img)
+    hostFlashSave(img);
+}
+
+int main(int argc, char** argv) {
+  static char buf[1024*1024];
+  FILE* fp = argc > 1 ? fopen(argv[1], "rb") : stdin;
+  size_t len;
+
+  if (!fp) {
+    perror(argv[1]);
+    return 2;
+  }
+  len = fread(buf, 1, sizeof(buf), fp);
+  if (fp != stdin)
+    fclose(fp);
+
+  img = getenv("FLASHIMG");
+  if (hostFlashInit(img)) {
+    perror("mmap");
+    return 2;
+  }
+  hostSetInput(buf, len);
+  atexit(saveImage);
+
+  setup();
+  for (;;)
+    loop();
+}
@@ -0,0 +1,216 @@
+//
+// インタプリタ(basic.cpp)のホスト上のテスト
+// 2026/10/18 新規作成
+//  プログラム行の一括登録(progBatchXXX())の結果が1行ずつの登録(doProgLine())と一致することを確認し、
+//  行番号順・逆順に追加した場合の一括登録の時間を表示する
+//  VAL()の結果(直接変換、トークン化結果キャッシュを含む)が従来と同じであることを確認する
+//
+// ビルド・実行(リポジトリのトップで、Linux)
+//  SRCS="test/stub/Arduino.cpp -x c++ arduinoBASIC_STM32.ino -x none basic.cpp host.cpp src/lib/tFlashMan.cpp
+//    src/lib/tSerialDev.cpp src/lib/tTermscreen.cpp src/lib/tscreenBase.cpp src/lib/ttbasic_error.cpp
+//    src/lib/ttbasic_numfmt.cpp -x c src/lib/mcurses.c"     (1行で指定)
+//  g++ -O2 -funsigned-char -fno-rtti -Itest/stub -I. -Isrc/lib -o basic_test test/basic_test.cpp $SRCS
+//  ./basic_test
+//  不一致があれば内容を表示し、終了コード1で終了する
+//
+
+#include <Arduino.h>
+#include <time.h>
+#include "basic.h"
+
+int doProgLine(uint16_t lineNumber, unsigned char* tokenPtr, int tokensLength);
+float lookupNumVariable(char *name);
+void setup();
+
+#define LINE_MAX_NUM  1000   // テストで登録する最大行数
+
+static unsigned long errCount = 0;  // 不一致件数
+
+// 登録する行
+typedef struct {
+  uint16_t lineNo;            // 行番号
+  uint8_t  len;               // トークン長
+  unsigned char tok[16];      // トークン(REM 文字列、空行は削除)
+} TestLine;
+
+static TestLine lines[LINE_MAX_NUM];
+static unsigned char expect[MEMORY_SIZE];
+static int expectLen;
+
+// 行の作成
+//  del : 1:空行(行の削除)
+static void makeLine(TestLine* l, uint16_t lineNo, uint16_t tag, uint8_t del) {
+  l->lineNo = lineNo;
+  if (del) {
+    l->tok[0] = TOKEN_EOL;
+    l->len = 1;
+  } else {
+    l->tok[0] = TOKEN_REM;
+    l->tok[1] = TOKEN_STRING;
+    l->len = 2 + sprintf((char*)&l->tok[2], "%u", tag) + 1;
+    l->tok[l->len++] = TOKEN_EOL;
+  }
+}
+
+// 既存のプログラム(行番号 base, base+step, ... のn行)の登録
+static void loadProgram(int n, uint16_t base, uint16_t step) {
+  TestLine l;
+  reset();
+  for (int i = 0; i < n; i++) {
+    makeLine(&l, base + i * step, 60000 + i, 0);
+    doProgLine(l.lineNo, l.tok, l.len);
+  }
+}
+
+// 1行ずつ登録した結果と一括登録した結果の比較
+//  title : 表示用のテスト名
+//  n     : 行数
+//  pre   : 既存のプログラムの行数
+static void checkBatch(const char* title, int n, int pre) {
+  loadProgram(pre, 5, 10);
+  for (int i = 0; i < n; i++)
+    doProgLine(lines[i].lineNo, lines[i].tok, lines[i].len);
+  expectLen = sysPROGEND;
+  memcpy(expect, mem, expectLen);
+
+  loadProgram(pre, 5, 10);
+  progBatchBegin();
+  for (int i = 0; i < n; i++)
+    progBatchAdd(lines[i].lineNo, lines[i].tok, lines[i].len);
+  progBatchCommit();
+
+  if (sysPROGEND != expectLen || memcmp(expect, mem, expectLen)) {
+    printf("NG batch %s: program %d bytes, expected %d bytes\n", title, sysPROGEND, expectLen);
+    errCount++;
+  }
+}
+
+// 一括登録の時間(μ秒、repeat回の平均)
+static double timeBatch(int n, int repeat) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int r = 0; r < repeat; r++) {
+    reset();
+    progBatchBegin();
+    for (int i = 0; i < n; i++)
+      progBatchAdd(lines[i].lineNo, lines[i].tok, lines[i].len);
+    progBatchCommit();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return ((t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3) / repeat;
+}
+
+// 一括登録
+static void testBatch() {
+  unsigned long e0 = errCount;
+  int n;
+
+  // 行番号順(途中でステージング領域が満杯になり、分割して登録する)
+  for (n = 0; n < 320; n++)
+    makeLine(&lines[n], 10 + n * 10, n, 0);
+  checkBatch("ascending", n, 0);
+  checkBatch("ascending(merge)", n, 40);
+
+  // 逆順
+  for (n = 0; n < 320; n++)
+    makeLine(&lines[n], 3200 - n * 10, n, 0);
+  checkBatch("descending", n, 0);
+
+  // 乱順、同じ行番号の置換、空行による削除
+  srand(1);
+  for (int t = 0; t < 200; t++) {
+    n = 1 + rand() % 400;
+    for (int i = 0; i < n; i++)
+      makeLine(&lines[i], 1 + rand() % 500, i, rand() % 8 == 0);
+    checkBatch("random", n, rand() % 50);
+  }
+  printf("%-28s 不一致 %lu\n", "一括登録", errCount - e0);
+
+  // 時間の比較(ステージング領域に収まる行数、既存のプログラムなし)
+  n = 240;
+  for (int i = 0; i < n; i++)
+    makeLine(&lines[i], 10 + i * 10, i, 0);
+  double asc = timeBatch(n, 2000);
+  for (int i = 0; i < n; i++)
+    makeLine(&lines[i], 10 + (n - 1 - i) * 10, i, 0);
+  double desc = timeBatch(n, 2000);
+  printf("%-28s %d行 行番号順 %.1f us 逆順 %.1f us\n", "一括登録の時間", n, asc, desc);
+}
+
+// VAL()の期待値(従来の字句解析・式の評価による結果)
+//  字句解析は指数部を扱わないため、"1E4"は1の後の変数E4となり、VAL()は末尾を無視して1を返す
+//  単項の'+'はない
+typedef struct {
+  const char* str;  // 文字列
+  uint8_t err;      // 1:ERROR_IN_VAL_INPUT
+  float val;        // 値
+} ValCase;
+
+static const ValCase valCases[] = {
+  { "5",            0, 5 },
+  { "-5",           0, -5 },
+  { " 12.5 ",       0, 12.5f },
+  { "- 3",          0, -3 },
+  { "--5",          0, 5 },
+  { "-.5",          0, -0.5f },
+  { ".5",           0, 0.5f },
+  { "3.",           0, 3 },
+  { ".",            0, 0 },
+  { "1 2",          0, 1 },
+  { "1+2",          0, 3 },
+  { "1E4",          0, 1 },
+  { "1e4",          0, 1 },
+  { "2.5E-3",       0, 2.5f },
+  { "1E+2",         0, 1 },
+  { "1E",           0, 1 },
+  { "2147483647",   0, 2147483647.0f },
+  { "-2147483648",  0, -2147483648.0f },
+  { "+5",           1, 0 },
+  { "+",            1, 0 },
+  { "5-",           1, 0 },
+  { "1.2.3",        1, 0 },
+  { "12345678901",  1, 0 },
+  { "E4",           1, 0 },
+  { "",             1, 0 },
+};
+
+// VAL()
+static void testVal() {
+  unsigned long e0 = errCount;
+  char line[64];
+  unsigned char tok[64];
+  int ret;
+  float v;
+
+  for (int r = 0; r < 2; r++) {   // 2回目はトークン化結果キャッシュを利用
+    for (size_t i = 0; i < sizeof(valCases) / sizeof(valCases[0]); i++) {
+      const ValCase* c = &valCases[i];
+      sprintf(line, "X=-999:X=VAL(\"%s\")", c->str);
+      ret = tokenize((unsigned char*)line, tok, sizeof(tok));
+      if (!ret)
+        ret = processInput(tok);
+      v = lookupNumVariable((char*)"X");
+      if (c->err ? ret != ERROR_IN_VAL_INPUT : (ret || v != c->val)) {
+        printf("NG val VAL(\"%s\"): error %d value %g, expected error %d value %g\n",
+               c->str, ret, v, c->err ? ERROR_IN_VAL_INPUT : 0, c->val);
+        errCount++;
+      }
+    }
+  }
+  printf("%-28s 不一致 %lu\n", "VAL()", errCount - e0);
+}
+
+int main() {
+  if (hostFlashInit(NULL)) {
+    perror("mmap");
+    return 2;
+  }
+  hostSetOutput(NULL);
+  setup();
+
+  testBatch();
+  testVal();
+
+  printf("不一致 %lu 件\n", errCount);
+  return errCount ? 1 : 0;
+}
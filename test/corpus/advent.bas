@@ -0,0 +1,33 @@
+10 REM TEXT ADVENTURE
+20 REM ROOMS 1-10, N/S/E/W TO MOVE
+30 R=1
+40 GOSUB 1000
+50 PRINT "DIRECTION (1=N 2=S 3=E 4=W)? ";:INPUT D
+60 IF D=1 THEN R=R+3
+70 IF D=2 THEN R=R-3
+80 IF D=3 THEN R=R+1
+90 IF D=4 THEN R=R-1
+100 IF R<1 THEN R=1
+110 IF R>10 THEN R=10
+120 IF R=7 THEN PRINT "YOU FOUND THE PRINCESS! YOU WIN!":STOP
+130 GOTO 40
+1000 IF R=1 THEN PRINT "YOU ARE IN A DARK FOREST. PATHS LEAD NOR"
+1010 IF R=2 THEN PRINT "YOU ARE AT THE EDGE OF A RIVER. A BRIDGE"
+1020 IF R=3 THEN PRINT "YOU ARE IN A SMALL HUT. THERE IS A TABLE"
+1030 IF R=4 THEN PRINT "YOU ARE ON A HILL. YOU CAN SEE A CASTLE "
+1040 IF R=5 THEN PRINT "YOU ARE AT THE CASTLE GATE. IT IS LOCKED"
+1050 IF R=6 THEN PRINT "YOU ARE IN THE CASTLE HALL. STAIRS GO UP"
+1060 IF R=7 THEN PRINT "YOU ARE IN THE TOWER. A PRINCESS IS HERE"
+1070 IF R=8 THEN PRINT "YOU ARE IN A CAVE. IT IS VERY COLD."
+1080 IF R=9 THEN PRINT "YOU ARE IN A MINE. THERE IS GOLD HERE."
+1090 IF R=10 THEN PRINT "YOU ARE IN A SWAMP. THE GROUND IS SOFT."
+2000 IF R=1 THEN PRINT "TH AND EAST."
+2010 IF R=2 THEN PRINT " CROSSES IT."
+2020 IF R=3 THEN PRINT " HERE."
+2030 IF R=4 THEN PRINT "TO THE NORTH."
+2040 IF R=5 THEN PRINT "."
+2050 IF R=6 THEN PRINT "."
+2060 IF R=7 THEN PRINT "."
+1100 GOTO 2000
+2200 PRINT "WHAT NOW?"
+2210 RETURN
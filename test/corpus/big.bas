@@ -0,0 +1,129 @@
+10 REM MAIN MENU FOR THE DATA LOGGER
+20 CLS
+30 PRINT "================================"
+40 PRINT "      DATA LOGGER  VERSION 1.2  "
+50 PRINT "================================"
+60 PRINT " 1. START LOGGING"
+70 PRINT " 2. SHOW LAST READINGS"
+80 PRINT " 3. SET SAMPLE INTERVAL"
+90 PRINT " 4. CALIBRATE SENSOR"
+100 PRINT " 5. CLEAR ALL READINGS"
+110 PRINT " 6. EXIT"
+120 PRINT "================================"
+130 PRINT "SELECT (1-6)? ";:INPUT S
+140 IF S=1 THEN GOSUB 1000
+150 IF S=2 THEN GOSUB 2000
+160 IF S=3 THEN GOSUB 3000
+170 IF S=4 THEN GOSUB 4000
+180 IF S=5 THEN GOSUB 5000
+190 IF S=6 THEN STOP
+200 GOTO 20
+1000 REM START LOGGING
+1010 PRINT "LOGGING... PRESS ESC TO STOP"
+1020 FOR I=1 TO 20
+1030 R(I)=ANALOGRD(0)*K
+1040 PRINT "SAMPLE ";I;": ";R(I)
+1050 PAUSE V
+1060 NEXT I
+1070 RETURN
+2000 REM SHOW LAST READINGS
+2010 PRINT "LAST READINGS:"
+2020 FOR I=1 TO 20
+2030 PRINT "SAMPLE ";I;": ";R(I)
+2040 NEXT I
+2050 RETURN
+3000 REM SET SAMPLE INTERVAL
+3010 PRINT "INTERVAL IN MS? ";:INPUT V
+3020 IF V<10 THEN PRINT "TOO SHORT":GOTO 3010
+3030 RETURN
+4000 REM CALIBRATE SENSOR
+4010 PRINT "APPLY REFERENCE VOLTAGE AND PRESS ENTER"
+4020 PRINT "REFERENCE VALUE? ";:INPUT RV
+4030 K=RV/ANALOGRD(0)
+4040 PRINT "SCALE FACTOR: ";K
+4050 RETURN
+5000 REM CLEAR ALL READINGS
+5010 FOR I=1 TO 20
+5020 R(I)=0
+5030 NEXT I
+5040 PRINT "CLEARED"
+5050 RETURN
+6010 REM LUNAR LANDER
+6020 REM LAND WITH A SPEED BELOW 5 M/S
+6030 CLS
+6040 PRINT "LUNAR LANDER"
+6050 PRINT "YOU ARE 1000 M ABOVE THE SURFACE."
+6060 PRINT "EACH TURN, ENTER THE FUEL TO BURN (0-30)."
+6070 H=1000
+6080 V=50
+6090 F=500
+6100 G=1.62
+6110 T=0
+6120 PRINT "TIME";" ";"HEIGHT";" ";"SPEED";" ";"FUEL"
+6130 PRINT T;" ";H;" ";V;" ";F
+6140 PRINT "BURN? ";:INPUT B
+6150 IF B<0 THEN B=0
+6160 IF B>30 THEN B=30
+6170 IF B>F THEN B=F
+6180 F=F-B
+6190 V=V+G*10-B*2
+6200 H=H-V*10
+6210 T=T+10
+6220 IF H>0 THEN GOTO 130
+6230 PRINT "TOUCHDOWN AT ";V;" M/S"
+6240 IF V<5 THEN PRINT "PERFECT LANDING!":GOTO 280
+6250 IF V<15 THEN PRINT "ROUGH LANDING, BUT YOU SURVIVED.":GOTO 280
+6260 PRINT "YOU CRASHED AND MADE A NEW CRATER ";INT(V/2);" M DEEP."
+6280 PRINT "PLAY AGAIN (1=YES)? ";:INPUT A
+6290 IF A=1 THEN GOTO 30
+6300 STOP
+7010 REM STRING FUNCTIONS DEMO
+7020 A$="HELLO, WORLD"
+7030 PRINT "STRING: ";A$
+7040 PRINT "LENGTH: ";LEN(A$)
+7050 PRINT "LEFT 5: ";LEFT$(A$,5)
+7060 PRINT "RIGHT 5: ";RIGHT$(A$,5)
+7070 PRINT "MID 8,5: ";MID$(A$,8,5)
+7080 REM REVERSE THE STRING
+7090 R$=""
+7100 FOR I=LEN(A$) TO 1 STEP -1
+7110 R$=R$+MID$(A$,I,1)
+7120 NEXT I
+7130 PRINT "REVERSED: ";R$
+7140 REM COUNT THE VOWELS
+7150 C=0
+7160 FOR I=1 TO LEN(A$)
+7170 C$=MID$(A$,I,1)
+7180 IF C$="A" OR C$="E" OR C$="I" OR C$="O" OR C$="U" THEN C=C+1
+7190 NEXT I
+7200 PRINT "VOWELS: ";C
+7210 PRINT "ENTER A NUMBER? ";:INPUT N$
+7220 PRINT "VALUE TIMES TWO: ";VAL(N$)*2
+7230 PRINT "AS STRING: ";STR$(VAL(N$)*2)
+7240 STOP
+8010 REM BUBBLE SORT DEMO
+8020 REM SORTS RANDOM NUMBERS AND PRINTS THEM
+8030 DIM A(50)
+8040 N=50
+8050 FOR I=1 TO N
+8060 A(I)=INT(RND*1000)
+8070 NEXT I
+8080 PRINT "BEFORE:"
+8090 GOSUB 300
+8100 FOR I=1 TO N-1
+8110 FOR J=1 TO N-I
+8120 IF A(J)<=A(J+1) THEN GOTO 160
+8130 T=A(J)
+8140 A(J)=A(J+1)
+8150 A(J+1)=T
+8160 NEXT J
+8170 NEXT I
+8180 PRINT "AFTER:"
+8190 GOSUB 300
+8200 STOP
+8300 REM PRINT THE ARRAY
+8310 FOR I=1 TO N
+8320 PRINT A(I);" ";
+8330 IF I MOD 10=0 THEN PRINT
+8340 NEXT I
+8350 RETURN
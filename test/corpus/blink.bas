@@ -0,0 +1,19 @@
+10 REM LED BLINK AND BUTTON MONITOR
+20 REM LED ON PIN 13, BUTTON ON PIN 2
+30 PINMODE 13,1
+40 PINMODE 2,2
+50 D=500
+60 C=0
+70 PIN 13,1
+80 PAUSE D
+90 PIN 13,0
+100 PAUSE D
+110 C=C+1
+120 IF PINREAD(2)=0 THEN GOSUB 200
+130 IF C MOD 10=0 THEN PRINT "BLINKS: ";C;" DELAY: ";D
+140 GOTO 70
+200 REM BUTTON PRESSED: SPEED UP
+210 D=D-50
+220 IF D<50 THEN D=500
+230 PRINT "BUTTON PRESSED, DELAY NOW ";D
+240 RETURN
@@ -0,0 +1,21 @@
+10 REM NUMBER GUESSING GAME
+20 REM GUESS A NUMBER FROM 1 TO 100
+30 CLS
+40 PRINT "*** NUMBER GUESSING GAME ***"
+50 PRINT "I AM THINKING OF A NUMBER"
+60 PRINT "BETWEEN 1 AND 100."
+70 N=INT(RND*100)+1
+80 T=0
+90 PRINT "YOUR GUESS? ";:INPUT G
+100 T=T+1
+110 IF G<1 THEN PRINT "TOO SMALL, TRY 1 TO 100":GOTO 90
+120 IF G>100 THEN PRINT "TOO BIG, TRY 1 TO 100":GOTO 90
+130 IF G<N THEN PRINT "HIGHER...":GOTO 90
+140 IF G>N THEN PRINT "LOWER...":GOTO 90
+150 PRINT "YOU GOT IT IN ";T;" TRIES!"
+160 IF T<=7 THEN PRINT "VERY GOOD!"
+170 IF T>7 THEN PRINT "YOU CAN DO BETTER."
+180 PRINT "PLAY AGAIN (1=YES)? ";:INPUT A
+190 IF A=1 THEN GOTO 30
+200 PRINT "BYE"
+210 STOP
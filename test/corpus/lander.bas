@@ -0,0 +1,29 @@
+10 REM LUNAR LANDER
+20 REM LAND WITH A SPEED BELOW 5 M/S
+30 CLS
+40 PRINT "LUNAR LANDER"
+50 PRINT "YOU ARE 1000 M ABOVE THE SURFACE."
+60 PRINT "EACH TURN, ENTER THE FUEL TO BURN (0-30)."
+70 H=1000
+80 V=50
+90 F=500
+100 G=1.62
+110 T=0
+120 PRINT "TIME";" ";"HEIGHT";" ";"SPEED";" ";"FUEL"
+130 PRINT T;" ";H;" ";V;" ";F
+140 PRINT "BURN? ";:INPUT B
+150 IF B<0 THEN B=0
+160 IF B>30 THEN B=30
+170 IF B>F THEN B=F
+180 F=F-B
+190 V=V+G*10-B*2
+200 H=H-V*10
+210 T=T+10
+220 IF H>0 THEN GOTO 130
+230 PRINT "TOUCHDOWN AT ";V;" M/S"
+240 IF V<5 THEN PRINT "PERFECT LANDING!":GOTO 280
+250 IF V<15 THEN PRINT "ROUGH LANDING, BUT YOU SURVIVED.":GOTO 280
+260 PRINT "YOU CRASHED AND MADE A NEW CRATER ";INT(V/2);" M DEEP."
+280 PRINT "PLAY AGAIN (1=YES)? ";:INPUT A
+290 IF A=1 THEN GOTO 30
+300 STOP
@@ -0,0 +1,50 @@
+10 REM MAIN MENU FOR THE DATA LOGGER
+20 CLS
+30 PRINT "================================"
+40 PRINT "      DATA LOGGER  VERSION 1.2  "
+50 PRINT "================================"
+60 PRINT " 1. START LOGGING"
+70 PRINT " 2. SHOW LAST READINGS"
+80 PRINT " 3. SET SAMPLE INTERVAL"
+90 PRINT " 4. CALIBRATE SENSOR"
+100 PRINT " 5. CLEAR ALL READINGS"
+110 PRINT " 6. EXIT"
+120 PRINT "================================"
+130 PRINT "SELECT (1-6)? ";:INPUT S
+140 IF S=1 THEN GOSUB 1000
+150 IF S=2 THEN GOSUB 2000
+160 IF S=3 THEN GOSUB 3000
+170 IF S=4 THEN GOSUB 4000
+180 IF S=5 THEN GOSUB 5000
+190 IF S=6 THEN STOP
+200 GOTO 20
+1000 REM START LOGGING
+1010 PRINT "LOGGING... PRESS ESC TO STOP"
+1020 FOR I=1 TO 20
+1030 R(I)=ANALOGRD(0)*K
+1040 PRINT "SAMPLE ";I;": ";R(I)
+1050 PAUSE V
+1060 NEXT I
+1070 RETURN
+2000 REM SHOW LAST READINGS
+2010 PRINT "LAST READINGS:"
+2020 FOR I=1 TO 20
+2030 PRINT "SAMPLE ";I;": ";R(I)
+2040 NEXT I
+2050 RETURN
+3000 REM SET SAMPLE INTERVAL
+3010 PRINT "INTERVAL IN MS? ";:INPUT V
+3020 IF V<10 THEN PRINT "TOO SHORT":GOTO 3010
+3030 RETURN
+4000 REM CALIBRATE SENSOR
+4010 PRINT "APPLY REFERENCE VOLTAGE AND PRESS ENTER"
+4020 PRINT "REFERENCE VALUE? ";:INPUT RV
+4030 K=RV/ANALOGRD(0)
+4040 PRINT "SCALE FACTOR: ";K
+4050 RETURN
+5000 REM CLEAR ALL READINGS
+5010 FOR I=1 TO 20
+5020 R(I)=0
+5030 NEXT I
+5040 PRINT "CLEARED"
+5050 RETURN
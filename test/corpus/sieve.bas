@@ -0,0 +1,16 @@
+10 REM SIEVE OF ERATOSTHENES
+20 REM PRINTS ALL PRIMES UP TO N
+30 N=500
+40 DIM F(500)
+50 FOR I=2 TO N
+60 F(I)=1
+70 NEXT I
+80 FOR I=2 TO N
+90 IF F(I)=0 THEN GOTO 140
+100 PRINT I;" ";
+110 FOR J=I*I TO N STEP I
+120 F(J)=0
+130 NEXT J
+140 NEXT I
+150 PRINT
+160 PRINT "DONE"
@@ -0,0 +1,26 @@
+10 REM BUBBLE SORT DEMO
+20 REM SORTS RANDOM NUMBERS AND PRINTS THEM
+30 DIM A(50)
+40 N=50
+50 FOR I=1 TO N
+60 A(I)=INT(RND*1000)
+70 NEXT I
+80 PRINT "BEFORE:"
+90 GOSUB 300
+100 FOR I=1 TO N-1
+110 FOR J=1 TO N-I
+120 IF A(J)<=A(J+1) THEN GOTO 160
+130 T=A(J)
+140 A(J)=A(J+1)
+150 A(J+1)=T
+160 NEXT J
+170 NEXT I
+180 PRINT "AFTER:"
+190 GOSUB 300
+200 STOP
+300 REM PRINT THE ARRAY
+310 FOR I=1 TO N
+320 PRINT A(I);" ";
+330 IF I MOD 10=0 THEN PRINT
+340 NEXT I
+350 RETURN
@@ -0,0 +1,24 @@
+10 REM STRING FUNCTIONS DEMO
+20 A$="HELLO, WORLD"
+30 PRINT "STRING: ";A$
+40 PRINT "LENGTH: ";LEN(A$)
+50 PRINT "LEFT 5: ";LEFT$(A$,5)
+60 PRINT "RIGHT 5: ";RIGHT$(A$,5)
+70 PRINT "MID 8,5: ";MID$(A$,8,5)
+80 REM REVERSE THE STRING
+90 R$=""
+100 FOR I=LEN(A$) TO 1 STEP -1
+110 R$=R$+MID$(A$,I,1)
+120 NEXT I
+130 PRINT "REVERSED: ";R$
+140 REM COUNT THE VOWELS
+150 C=0
+160 FOR I=1 TO LEN(A$)
+170 C$=MID$(A$,I,1)
+180 IF C$="A" OR C$="E" OR C$="I" OR C$="O" OR C$="U" THEN C=C+1
+190 NEXT I
+200 PRINT "VOWELS: ";C
+210 PRINT "ENTER A NUMBER? ";:INPUT N$
+220 PRINT "VALUE TIMES TWO: ";VAL(N$)*2
+230 PRINT "AS STRING: ";STR$(VAL(N$)*2)
+240 STOP
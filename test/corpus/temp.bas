@@ -0,0 +1,16 @@
+10 REM TEMPERATURE CONVERSION TABLE
+20 REM CELSIUS TO FAHRENHEIT AND KELVIN
+30 CLS
+40 PRINT "CELSIUS";" ";"FAHRENHEIT";" ";"KELVIN"
+50 PRINT "-------";" ";"----------";" ";"------"
+60 FOR C=-40 TO 100 STEP 10
+70 F=C*9/5+32
+80 K=C+273.15
+90 PRINT C;" ";F;" ";K
+100 NEXT C
+110 PRINT
+120 PRINT "CONVERT A VALUE (C)? ";:INPUT C
+130 PRINT C;" C = ";C*9/5+32;" F = ";C+273.15;" K"
+140 PRINT "AGAIN (1=YES)? ";:INPUT A
+150 IF A=1 THEN GOTO 120
+160 STOP
@@ -0,0 +1,230 @@
+//
+// プログラムのLZ圧縮保存(tFlashMan)のホスト上のテスト
+// 2026/10/18 新規作成
+//  test/corpus/*.bas をトークン化して非圧縮・圧縮で保存し、読み込んだ内容が一致することを確認する
+//  あわせて圧縮率、保存・読込みの速度、書込み・消去回数を非圧縮と圧縮で比較して表示する
+//
+// ビルド・実行(リポジトリのトップで、Linux)
+//  SRCS はbasic_test.cppと同じ
+//  g++ -O2 -funsigned-char -fno-rtti -Itest/stub -I. -Isrc/lib -o flashlz_test test/flashlz_test.cpp $SRCS
+//  ./flashlz_test
+//  不一致があれば内容を表示し、終了コード1で終了する
+//
+
+#include <Arduino.h>
+#include <time.h>
+#include "basic.h"
+#include "host.h"
+#include "ttbasic_error.h"
+
+void setup();
+
+#define CORPUS_DIR   "test/corpus/"
+#define CORPUS_NUM   10      // コーパスのプログラム数
+#define AREA_TOP     (0x08000000 + (FLASH_PAGE_NUM - FLASH_AREA_PAGE_NUM - 2) * FLASH_PAGE_SIZE)
+
+static const char* corpusName[CORPUS_NUM] = {
+  "advent", "big", "blink", "guess", "lander", "menu", "sieve", "sort", "strings", "temp",
+};
+
+static unsigned long errCount = 0;  // 不一致件数
+
+static uint8_t  corpus[CORPUS_NUM][MEMORY_SIZE];    // トークン化したプログラム
+static uint16_t corpusLen[CORPUS_NUM];
+static uint8_t  model[FLASH_SAVE_NUM][MEMORY_SIZE];  // 保存したプログラム(期待値)
+static uint16_t modelLen[FLASH_SAVE_NUM];
+static uint8_t  buf[MEMORY_SIZE];
+
+// 経過時間(秒)
+static double elapsed(struct timespec* t0) {
+  struct timespec t1;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// 1行の登録(NEW後に行番号付きの行を入力した場合と同じ)
+static void enterLine(const char* line) {
+  unsigned char tok[256];
+  if (tokenize((unsigned char*)line, tok, sizeof(tok)) || processInput(tok)) {
+    printf("NG line: %s\n", line);
+    errCount++;
+  }
+}
+
+// コーパスの読込み・トークン化
+// 戻り値 0:正常 1:ファイルなし
+static uint8_t loadCorpus() {
+  char name[64], line[256];
+  FILE* fp;
+
+  for (int k = 0; k < CORPUS_NUM; k++) {
+    snprintf(name, sizeof(name), CORPUS_DIR "%s.bas", corpusName[k]);
+    if (!(fp = fopen(name, "r"))) {
+      perror(name);
+      return 1;
+    }
+    reset();
+    while (fgets(line, sizeof(line), fp)) {
+      line[strcspn(line, "\r\n")] = 0;
+      if (*line)
+        enterLine(line);
+    }
+    fclose(fp);
+    corpusLen[k] = sysPROGEND;
+    memcpy(corpus[k], mem, sysPROGEND);
+  }
+  return 0;
+}
+
+// 空のプログラム保存領域
+static void blankArea() {
+  hostFlashInit(NULL);
+  FlashMan.init(FLASH_PAGE_NUM, FLASH_PAGE_SIZE, FLASH_SAVE_NUM, FLASH_PAGE_PAR_PRG, FLASH_AREA_PAGE_NUM);
+  FlashMan.scanPrgArea();
+  memset(modelLen, 0, sizeof(modelLen));
+}
+
+// 保存内容の照合
+static void verify(const char* where) {
+  uint16_t len;
+
+  for (int i = 0; i < FLASH_SAVE_NUM; i++) {
+    len = FlashMan.isExistPrg(i) ? FlashMan.getPrgSize(i) : 0;
+    if (len && FlashMan.loadProgram(i, buf, &len))
+      len = 0xffff;
+    if (len != modelLen[i] || (len && memcmp(buf, model[i], len))) {
+      if (errCount < 10)
+        printf("NG %s: prog %d len %u (expected %u)\n", where, i, len, modelLen[i]);
+      errCount++;
+    }
+  }
+}
+
+// 1回の保存・削除
+//  no : プログラム番号, p : プログラム, len : プログラム長(0:削除), pack : 1:圧縮
+// 戻り値
+//  tFlashMan::saveProgram()の戻り値
+static uint8_t saveOne(int no, uint8_t* p, uint16_t len, uint8_t pack) {
+  uint8_t rc = FlashMan.saveProgram(no, p, len, pack);
+  if (!rc) {
+    modelLen[no] = len;
+    memcpy(model[no], p, len);
+  }
+  return rc;
+}
+
+// コーパスの保存
+// 圧縮率、書込み回数、保存領域の使用量、保存・読込みの速度を表示する
+static void testCorpus(uint8_t pack) {
+  unsigned long e0 = errCount;
+  uint32_t raw = 0, stored = 0, used = 0, w0;
+  struct timespec t0;
+  double tSave = 0, tLoad = 0;
+  int round = 200;
+  PrgRecHeader* h;
+
+  blankArea();
+  w0 = hostWriteCount();
+  for (int k = 0; k < CORPUS_NUM; k++) {
+    if (saveOne(k, corpus[k], corpusLen[k], pack)) {
+      printf("NG corpus: save %s\n", corpusName[k]);
+      errCount++;
+    }
+    raw += corpusLen[k];
+  }
+  w0 = hostWriteCount() - w0;
+  verify("corpus");
+
+  // 格納データ長の合計(空の保存領域の先頭から順にレコードを辿る)
+  for (h = (PrgRecHeader*)(uintptr_t)AREA_TOP; h->magic == PRGREC_MAGIC;
+       h = (PrgRecHeader*)((uint8_t*)h + PRGREC_HDR_SIZE + ((h->storeLen + 1) & ~1))) {
+    stored += h->storeLen;
+    used += PRGREC_HDR_SIZE + ((h->storeLen + 1) & ~1);
+  }
+
+  // 速度(空の保存領域への保存、読込み)
+  for (int r = 0; r < round; r++) {
+    blankArea();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int k = 0; k < CORPUS_NUM; k++)
+      FlashMan.saveProgram(k, corpus[k], corpusLen[k], pack);
+    tSave += elapsed(&t0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int k = 0; k < CORPUS_NUM; k++) {
+      uint16_t len;
+      FlashMan.loadProgram(k, buf, &len);
+    }
+    tLoad += elapsed(&t0);
+  }
+
+  printf("%-20s %5u -> %5u バイト 比 %.3f 書込み %4u 回 使用 %5u バイト 保存 %6.1f MB/s 読込み %6.1f MB/s 不一致 %lu\n",
+         pack ? "コーパス(圧縮)" : "コーパス(非圧縮)", raw, stored, (double)stored / raw, w0, used,
+         raw * round / tSave / 1e6, raw * round / tLoad / 1e6, errCount - e0);
+}
+
+// 繰り返し保存するプログラムの作成
+//  tag : プログラムの識別番号(REM文に埋め込む), lines : 行数
+// 戻り値
+//  プログラム長(mem[]に作成)
+static uint16_t makeProgram(int tag, int lines) {
+  char line[80];
+  reset();
+  for (int j = 1; j <= lines; j++) {
+    int n = snprintf(line, sizeof(line), "%d REM T%d L%d ", j * 10, tag, j);
+    memset(line + n, 'X', (tag * j) % 30);
+    line[n + (tag * j) % 30] = 0;
+    enterLine(line);
+  }
+  return sysPROGEND;
+}
+
+// 保存・削除の繰り返し(番号、行数は乱数)
+//  title : 表示用のテスト名, count : 保存・削除の回数, maxLines : 最大行数, delRate : 削除の割合(1/n、0:削除なし)
+static void testStress(const char* title, int count, int maxLines, int delRate, uint8_t pack) {
+  unsigned long e0 = errCount, full = 0;
+  uint32_t er0;
+  uint16_t len;
+  uint8_t rc;
+
+  blankArea();
+  er0 = hostEraseCount();
+  srand(2);
+  for (int i = 0; i < count; i++) {
+    int no = rand() % FLASH_SAVE_NUM;
+    if (delRate && rand() % delRate == 0)
+      len = 0;
+    else
+      len = makeProgram(i, 1 + rand() % maxLines);
+    rc = saveOne(no, mem, len, pack);
+    if (rc == ERR_FLASH_FULL && len)
+      full++;
+    else if (rc) {
+      printf("NG %s: save %d len %u rc %u\n", title, no, len, rc);
+      errCount++;
+    }
+    verify(title);
+  }
+  printf("%-20s %5d 回 Flash full %3lu 消去 %4u 回 不一致 %lu\n",
+         title, count, full, hostEraseCount() - er0, errCount - e0);
+}
+
+int main() {
+  if (hostFlashInit(NULL)) {
+    perror("mmap");
+    return 2;
+  }
+  hostSetOutput(NULL);
+  setup();
+  if (loadCorpus())
+    return 2;
+
+  testCorpus(0);
+  testCorpus(1);
+  testStress("短いプログラム", 600, 23, 0, 0);
+  testStress("短いプログラム(圧縮)", 600, 23, 0, 1);
+  testStress("長いプログラム・削除", 300, 90, 7, 0);
+  testStress("長いプログラム・削除(圧縮)", 300, 90, 7, 1);
+
+  printf("不一致 %lu 件\n", errCount);
+  return errCount ? 1 : 0;
+}
@@ -0,0 +1,344 @@
+//
+// プログラム保存領域(tFlashMan)のホスト上のテスト
+// 2026/10/18 新規作成
+// 2026/10/18 電源断させる操作をpowerFailOp()に分離(-Wclobbered対策)
+//  フラッシュメモリをページ単位の消去・16ビット単位の書込みで模擬し、
+//  保存・削除・再起動(走査)、GC、電源断、旧形式(固定スロット)の保存領域を確認する
+//
+// ビルド・実行(リポジトリのトップで、Linux)
+//  g++ -O2 -Wall -Wextra -Itest/stub -Isrc/lib -o flashsim_test test/flashsim_test.cpp src/lib/tFlashMan.cpp
+//  ./flashsim_test [乱数の種]
+//  不一致があれば内容を表示し、終了コード1で終了する
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include "tFlashMan.h"
+#include "ttbasic_error.h"
+
+// フラッシュメモリの構成(host.hと同じ)
+#define FLASH_START          0x08000000  // 先頭アドレス
+#define FLASH_PAGE_NUM       128         // 全ページ数
+#define FLASH_PAGE_SIZE      1024        // ページ内バイト数
+#define FLASH_PAGE_PAR_PRG   4           // 1プログラム当たりの最大ページ数
+#define FLASH_SAVE_NUM       16          // プログラム保存可能数
+#define FLASH_AREA_PAGE_NUM  24          // プログラム保存領域のページ数
+#define AREA_TOP_PAGE        (FLASH_PAGE_NUM - FLASH_AREA_PAGE_NUM - 2)
+#define PRG_MAX_LEN          (FLASH_PAGE_PAR_PRG * FLASH_PAGE_SIZE)
+
+EEPROMClass EEPROM;
+TFlash_Class TFlash;
+static tFlashMan FlashMan(FLASH_PAGE_NUM, FLASH_PAGE_SIZE, FLASH_SAVE_NUM, FLASH_PAGE_PAR_PRG, FLASH_AREA_PAGE_NUM);
+
+static uint8_t* flash;                       // 模擬フラッシュメモリ
+static uint32_t eraseCnt[FLASH_PAGE_NUM];    // ページ別消去回数
+static long failAt = -1;                     // 電源断させる操作回数(-1:なし)
+static long opCount;                         // 消去・書込みの操作回数
+static jmp_buf powerFail;                    // 電源断時の戻り先
+
+static unsigned long errCount = 0;           // 不一致件数
+
+// 電源断のチェック(指定回数の操作で電源断とする)
+//  pageAdr : 消去中のページ(0:書込み)
+static void checkPower(uint32_t pageAdr) {
+  if (failAt < 0 || ++opCount <= failAt)
+    return;
+  if (pageAdr)
+    memset((void*)(uintptr_t)pageAdr, 0xff, FLASH_PAGE_SIZE / 2); // 消去途中(前半のみ消去)
+  failAt = -1;
+  longjmp(powerFail, 1);
+}
+
+// *** フラッシュメモリの模擬(TFlash_Class) ***
+TFLASH_Status TFlash_Class::erasePage(uint32_t pageAddress) {
+  uint32_t adr = pageAddress & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+  if (adr < FLASH_START || adr >= FLASH_START + FLASH_PAGE_NUM * FLASH_PAGE_SIZE)
+    return TFLASH_BAD_ADDRESS;
+  checkPower(adr);
+  eraseCnt[(adr - FLASH_START) / FLASH_PAGE_SIZE]++;
+  memset((void*)(uintptr_t)adr, 0xff, FLASH_PAGE_SIZE);
+  return TFLASH_COMPLETE;
+}
+
+TFLASH_Status TFlash_Class::write(uint16_t* adr, uint16_t data) {
+  checkPower(0);
+  if (*adr != 0xffff && data != 0)  // 消去状態以外には0のみ書込み可能
+    return TFLASH_ERROR_PG;
+  *adr = data;
+  return TFLASH_COMPLETE;
+}
+
+TFLASH_Status TFlash_Class::write(uint16_t* adr, uint8_t* data, uint16_t len) {
+  TFLASH_Status rc = TFLASH_COMPLETE;
+  for (uint16_t i = 0; rc == TFLASH_COMPLETE && i < len; i += 2)
+    rc = write(adr++, (uint16_t)(data[i] | (i + 1 < len ? data[i + 1] << 8 : 0xff00)));
+  return rc;
+}
+
+void TFlash_Class::lock() {}
+void TFlash_Class::unlock() {}
+
+// *** 期待値(プログラム番号別の最新の保存内容) ***
+static uint8_t  model[FLASH_SAVE_NUM][PRG_MAX_LEN];
+static uint16_t modelLen[FLASH_SAVE_NUM];    // 0:保存なし
+static uint8_t  prg[PRG_MAX_LEN];            // 保存するプログラム
+static uint8_t  buf[PRG_MAX_LEN];            // 読込み用
+
+// 保存するプログラムの作成([1行のバイト長 2バイト][行番号 2バイト][命令文]の並び)
+//  len  : おおよそのプログラム長
+//  text : 1:圧縮が効く内容 0:乱数
+static uint16_t makePrg(uint16_t len, uint8_t text) {
+  static const char words[] = "PRINT FOR NEXT GOTO GOSUB RETURN REM IF THEN A=A+1 ";
+  uint16_t p = 0, n, lineNo = 10;
+
+  while (p + 8 <= len) {
+    n = 5 + rand() % 40;
+    if (p + n > len)
+      n = len - p;
+    prg[p] = n & 0xff;       prg[p + 1] = n >> 8;
+    prg[p + 2] = lineNo & 0xff; prg[p + 3] = lineNo >> 8;
+    for (uint16_t i = 4; i < n - 1; i++)
+      prg[p + i] = text ? words[(lineNo + i) % (sizeof(words) - 1)] : rand() % 255 + 1;
+    prg[p + n - 1] = 0;
+    p += n;
+    lineNo += 10;
+  }
+  return p;
+}
+
+// 保存するプログラムの作成(長さは乱数、1/4は削除としてプログラム長0)
+static uint16_t randomLen() {
+  if (rand() % 4 == 0)
+    return 0;
+  return makePrg(16 + rand() % (rand() % 8 ? 600 : PRG_MAX_LEN - 16), rand() % 2);
+}
+
+// 再起動(初期化と保存領域の走査)
+static void reboot() {
+  FlashMan.init(FLASH_PAGE_NUM, FLASH_PAGE_SIZE, FLASH_SAVE_NUM, FLASH_PAGE_PAR_PRG, FLASH_AREA_PAGE_NUM);
+  FlashMan.scanPrgArea();
+}
+
+// 保存内容の照合
+//  alt    : 期待値以外に許す内容のプログラム番号(-1:なし)
+//  altLen : 許す内容のプログラム長(0:保存なし)、内容はprg[]
+//  where  : 表示用の状況
+static void verify(int alt, uint16_t altLen, const char* where) {
+  uint16_t len;
+  uint8_t* p;
+
+  for (int i = 0; i < FLASH_SAVE_NUM; i++) {
+    len = FlashMan.isExistPrg(i) ? FlashMan.getPrgSize(i) : 0;
+    if (len && FlashMan.loadProgram(i, buf, &len))
+      len = 0xffff;
+    p = FlashMan.getPrgAddress(i);
+    if (len == modelLen[i] && (!len || !memcmp(buf, model[i], len)) && (!p || !memcmp(p, buf, len)))
+      continue;
+    if (i == alt && len == altLen && (!len || !memcmp(buf, prg, len)) && (!p || !memcmp(p, buf, len))) {
+      // 電源断前の保存が完了していた
+      modelLen[i] = len;
+      memcpy(model[i], prg, len);
+      continue;
+    }
+    if (errCount < 10)
+      printf("NG %s: prog %d len %u (expected %u)\n", where, i, len, modelLen[i]);
+    errCount++;
+  }
+}
+
+// 1回の保存・削除
+//  no : プログラム番号, len : プログラム長(0:削除)
+// 戻り値
+//  tFlashMan::saveProgram()の戻り値
+static uint8_t saveOne(int no, uint16_t len, uint8_t pack) {
+  uint8_t rc = FlashMan.saveProgram(no, prg, len, pack);
+  if (!rc) {
+    modelLen[no] = len;
+    memcpy(model[no], prg, len);
+  }
+  return rc;
+}
+
+// 保存・削除と再起動の繰り返し(GCと消去回数の分散)
+static void testWorkload(long count) {
+  unsigned long full = 0, e0 = errCount;
+  uint32_t min = 0xffffffff, max = 0;
+  uint8_t rc;
+
+  for (long i = 0; i < count; i++) {
+    int no = rand() % FLASH_SAVE_NUM;
+    uint16_t len = randomLen();
+    rc = saveOne(no, len, rand() % 2);
+    if (rc == ERR_FLASH_FULL && !len) {
+      printf("NG workload: delete %d rc %u\n", no, rc);  // 削除は空き不足にならないこと
+      errCount++;
+    } else if (rc == ERR_FLASH_FULL)
+      full++;
+    else if (rc) {
+      printf("NG workload: save %d len %u rc %u\n", no, len, rc);
+      errCount++;
+    }
+    if (rand() % 16 == 0)
+      reboot();
+    verify(-1, 0, "workload");
+  }
+  for (int pg = 0; pg < FLASH_AREA_PAGE_NUM; pg++) {
+    if (eraseCnt[AREA_TOP_PAGE + pg] < min) min = eraseCnt[AREA_TOP_PAGE + pg];
+    if (eraseCnt[AREA_TOP_PAGE + pg] > max) max = eraseCnt[AREA_TOP_PAGE + pg];
+  }
+  printf("%-20s %8ld 回 Flash full %lu 消去回数 min %u max %u 不一致 %lu\n",
+         "保存・削除", count, full, min, max, errCount - e0);
+}
+
+// 電源断させる操作(at回目の消去・書込みで電源断)
+// setjmp()はこの関数で呼び、呼出し元のローカル変数がlongjmp()で壊れないようにする
+//  no : 保存するプログラム番号(-1:format())
+// 戻り値 1:電源断 0:完了
+static uint8_t powerFailOp(long at, int no, uint16_t len, uint8_t pack) {
+  opCount = 0;
+  failAt = at;
+  if (setjmp(powerFail))
+    return 1;
+  if (no < 0)
+    FlashMan.format();
+  else
+    FlashMan.saveProgram(no, prg, len, pack);
+  failAt = -1;
+  return 0;
+}
+
+// 保存・削除中の電源断
+// 操作回数を変えて電源断させ、再起動後に、保存中の番号は保存前か保存後の内容、それ以外は元の内容であること、
+// その後も保存できることを確認する
+static void testPowerFail(long count) {
+  unsigned long e0 = errCount, injected = 0;
+  uint8_t snap[FLASH_AREA_PAGE_NUM * FLASH_PAGE_SIZE];
+  uint8_t* area = flash + AREA_TOP_PAGE * FLASH_PAGE_SIZE;
+  uint8_t rc;
+
+  for (long i = 0; i < count; i++) {
+    int no = rand() % FLASH_SAVE_NUM;
+    uint8_t pack = rand() % 2;
+    uint16_t len = randomLen();
+
+    // 電源断なしの操作回数
+    memcpy(snap, area, sizeof(snap));
+    opCount = 0;
+    failAt = 0x7fffffff;
+    FlashMan.saveProgram(no, prg, len, pack);
+    long ops = opCount;
+    failAt = -1;
+    memcpy(area, snap, sizeof(snap));
+    reboot();
+
+    if (ops) {
+      injected += powerFailOp(rand() % ops, no, len, pack);
+      reboot();
+      verify(no, len, "power fail");
+      reboot();
+      verify(-1, 0, "power fail(2nd boot)");
+    }
+    rc = saveOne(no, len, pack);
+    if (rc && rc != ERR_FLASH_FULL) {
+      printf("NG power fail: save after recovery %d len %u rc %u\n", no, len, rc);
+      errCount++;
+    }
+    verify(-1, 0, "after recovery");
+  }
+  printf("%-20s %8lu 回 不一致 %lu\n", "電源断", injected, errCount - e0);
+}
+
+// 旧形式(固定スロット)の保存領域
+// スロットにプログラムとスロット末尾のプログラム長を書き、消去されずに読めること、保存できないこと、
+// format()後は空の保存領域として保存できること、format()中の電源断後も旧形式か空の保存領域であることを確認する
+static void testLegacy() {
+  unsigned long e0 = errCount;
+  uint8_t* area = flash + AREA_TOP_PAGE * FLASH_PAGE_SIZE;
+  uint8_t snap[FLASH_AREA_PAGE_NUM * FLASH_PAGE_SIZE];
+  uint32_t slot = FLASH_PAGE_PAR_PRG * FLASH_PAGE_SIZE;
+  int slots = FLASH_AREA_PAGE_NUM / FLASH_PAGE_PAR_PRG;
+  uint16_t len;
+
+  // 旧形式の保存領域の作成(スロット0,2,5にプログラム、残りは消去状態)
+  memset(area, 0xff, sizeof(snap));
+  memset(modelLen, 0, sizeof(modelLen));
+  for (int i = 0; i < slots; i += (i == 0 ? 2 : 3)) {
+    len = makePrg(100 + rand() % 3000, 1);
+    memset(area + i * slot, 0, slot);                // mem[]全体を保存していた
+    memcpy(area + i * slot, prg, len);
+    area[i * slot + slot - 2] = len & 0xff;
+    area[i * slot + slot - 1] = len >> 8;
+    modelLen[i] = len;
+    memcpy(model[i], prg, len);
+  }
+  memcpy(snap, area, sizeof(snap));
+
+  reboot();
+  if (!FlashMan.isLegacy() || memcmp(snap, area, sizeof(snap))) {
+    printf("NG legacy: not detected or erased\n");
+    errCount++;
+  }
+  verify(-1, 0, "legacy");
+  len = makePrg(200, 1);
+  if (FlashMan.saveProgram(1, prg, len) != ERR_FLASH_OLD || FlashMan.saveProgram(0, prg, 0) != ERR_FLASH_OLD ||
+      memcmp(snap, area, sizeof(snap))) {
+    printf("NG legacy: saved to old format area\n");
+    errCount++;
+  }
+  reboot();
+  verify(-1, 0, "legacy(2nd boot)");
+
+  // format()中の電源断
+  for (long n = 0; n < slots * FLASH_PAGE_PAR_PRG + 1; n++) {
+    memcpy(area, snap, sizeof(snap));
+    reboot();
+    powerFailOp(n, -1, 0, 0);
+    reboot();
+    len = makePrg(300, 0);
+    if (FlashMan.isLegacy() ? FlashMan.saveProgram(3, prg, len) != ERR_FLASH_OLD
+                            : FlashMan.saveProgram(3, prg, len) != 0 || FlashMan.getPrgSize(0) || FlashMan.getPrgSize(3) != len) {
+      printf("NG legacy: format power fail at %ld\n", n);
+      errCount++;
+    }
+  }
+
+  // format()後
+  memcpy(area, snap, sizeof(snap));
+  reboot();
+  if (FlashMan.format() || FlashMan.isLegacy()) {
+    printf("NG legacy: format\n");
+    errCount++;
+  }
+  memset(modelLen, 0, sizeof(modelLen));
+  verify(-1, 0, "format");
+  len = makePrg(500, 1);
+  if (saveOne(4, len, 0))
+    errCount++;
+  reboot();
+  verify(-1, 0, "format(reboot)");
+  printf("%-20s %8s    不一致 %lu\n", "旧形式", "", errCount - e0);
+}
+
+int main(int argc, char** argv) {
+  void* p = mmap((void*)FLASH_START, FLASH_PAGE_NUM * FLASH_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap");
+    return 2;
+  }
+  flash = (uint8_t*)p;
+  memset(flash, 0xff, FLASH_PAGE_NUM * FLASH_PAGE_SIZE);
+  srand(argc > 1 ? atoi(argv[1]) : 1);
+
+  reboot();
+  testWorkload(20000);
+  testPowerFail(3000);
+  testLegacy();
+
+  printf("不一致 %lu 件\n", errCount);
+  return errCount ? 1 : 0;
+}
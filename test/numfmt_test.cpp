@@ -0,0 +1,191 @@
+//
+// 数値の文字列変換(ttbasic_numfmt.cpp)のホスト上のテスト
+// 2026/10/18 新規作成
+//  従来のlog10()/dtostrf()/"%6.2e"による変換結果と一致することを確認する
+//  (log10()による桁数は、ホストのlibmの丸めに依存しない厳密な値で比較する)
+//
+// ビルド・実行(リポジトリのトップで)
+//  g++ -O2 -Wall -Wextra -o numfmt_test test/numfmt_test.cpp src/lib/ttbasic_numfmt.cpp
+//  ./numfmt_test        固定小数点表記の範囲を7個おきに比較(約4千万件)
+//  ./numfmt_test full   固定小数点表記の範囲をすべて比較(約2億8千万件)
+//  不一致があれば先頭の数件を表示し、終了コード1で終了する
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "../src/lib/ttbasic_numfmt.h"
+
+#define FIX_MIN  0x38d1b718   // 0.0001以上の最小のfloat
+#define FIX_MAX  0x49742400   // 1000000
+
+static unsigned long errCount = 0;  // 不一致件数
+static unsigned long testCount = 0; // 比較件数
+
+// Arduino STM32のdtostrf()と同じ変換
+static char *ref_dtostrf(double val, signed char width, unsigned char prec, char *sout) {
+  char fmt[20];
+  sprintf(fmt, "%%%d.%df", width, prec);
+  sprintf(sout, fmt, val);
+  return sout;
+}
+
+// 整数部の桁数(floor(log10(a))+1)の厳密な値
+// a(0.0001以上1000000以下)を10^4倍した値と10のべき乗を、double型で誤差なく比較する
+// (floatの仮数24ビット×10^4は38ビットに収まる)
+static int refDigits(float a) {
+  double x = (double)a * 10000.0;
+  double p = 10.0;
+  int d = -3;
+
+  while (x >= p) {
+    p *= 10.0;
+    d++;
+  }
+  return d;
+}
+
+// 従来のhost_floatToStr()(桁数を求めてdtostrf()で変換)
+// 桁数はlog10f()の実装による丸めの違いを含まない厳密な値とする
+static char *ref_floatToStr(float f, char *buf) {
+  float a = fabs(f);
+  if (f == 0.0f) {
+    buf[0] = '0';
+    buf[1] = 0;
+  } else if (a < 0.0001 || a > 1000000) {
+    sprintf(buf, "%6.2e", f);
+  } else {
+    int decPos = 7 - refDigits(a);
+    ref_dtostrf(f, 1, decPos, buf);
+    if (decPos) {
+      // remove trailing 0s
+      char *p = buf;
+      while (*p) p++;
+      p--;
+      while (*p == '0') {
+        *p-- = 0;
+      }
+      if (*p == '.') *p = 0;
+    }
+  }
+  return buf;
+}
+
+// 1件の比較
+static void checkFloat(uint32_t u) {
+  union { float f; uint32_t u; } v;
+  char s1[40], s2[40];
+
+  v.u = u;
+  if (isnan(v.f))
+    return;
+  ref_floatToStr(v.f, s1);
+  host_floatToStr(v.f, s2);
+  testCount++;
+  if (strcmp(s1, s2)) {
+    if (errCount < 10)
+      printf("NG float %08x %.9g: old \"%s\" new \"%s\"\n", u, v.f, s1, s2);
+    errCount++;
+  }
+}
+
+// 10のべき乗の直前の値(期待する変換結果)
+static const struct {
+  uint32_t u;
+  const char *str;
+} fixCases[] = {
+  { 0x3a83126e, "0.0009999999" },
+  { 0x3dcccccc, "0.09999999" },
+  { 0x3f7fffff, "0.9999999" },
+  { 0x42c7fffe, "99.99998" },
+  { 0x42c7ffff, "99.99999" },
+  { 0x42c80000, "100" },
+  { 0x4479fffa, "999.9996" },
+  { 0x497423ff, "999999.9" },
+};
+
+// 変換結果の確認
+static void checkFix(uint32_t u, const char *str) {
+  union { float f; uint32_t u; } v;
+  char s[40];
+
+  v.u = u;
+  host_floatToStr(v.f, s);
+  testCount++;
+  if (strcmp(s, str)) {
+    if (errCount < 10)
+      printf("NG float %08x %.9g: \"%s\" expected \"%s\"\n", u, v.f, s, str);
+    errCount++;
+  }
+}
+
+// 範囲の比較(step個おき、範囲の両端は必ず含める)
+static void sweepFloat(const char *title, uint32_t from, uint32_t to, uint32_t step) {
+  unsigned long n0 = testCount, e0 = errCount;
+  uint64_t u;
+
+  for (u = from; u <= to; u += step)
+    checkFloat((uint32_t)u);
+  checkFloat(to);
+  printf("%-28s %10lu 件 不一致 %lu\n", title, testCount - n0, errCount - e0);
+}
+
+// 整数の比較
+static void checkInt(long n) {
+  char s1[24], s2[24];
+  int len;
+
+  sprintf(s1, "%ld", n);
+  len = host_intToStr(n, s2);
+  testCount++;
+  if (strcmp(s1, s2) || len != (int)strlen(s1)) {
+    if (errCount < 10)
+      printf("NG int %ld: \"%s\" \"%s\" len %d\n", n, s1, s2, len);
+    errCount++;
+  }
+}
+
+int main(int argc, char **argv) {
+  uint32_t step = (argc > 1 && !strcmp(argv[1], "full")) ? 1 : 7;
+  unsigned long n0, e0;
+  int64_t n;
+
+  // 固定小数点表記の範囲と前後(指数表記との境界)
+  sweepFloat("固定小数点(正)", FIX_MIN - 1000, FIX_MAX + 1000, step);
+  sweepFloat("固定小数点(負)", 0x80000000 | (FIX_MIN - 1000), 0x80000000 | (FIX_MAX + 1000), step * 13);
+
+  // 桁数の境界(10のべき乗)前後
+  n0 = testCount; e0 = errCount;
+  for (int e = -4; e <= 6; e++) {
+    union { float f; uint32_t u; } v;
+    v.f = (float)pow(10.0, e);
+    for (int d = -64; d <= 64; d++) {
+      checkFloat(v.u + d);
+      checkFloat((v.u + d) | 0x80000000);
+    }
+  }
+  printf("%-28s %10lu 件 不一致 %lu\n", "10のべき乗の前後", testCount - n0, errCount - e0);
+
+  // 10のべき乗の直前の値(下の桁数として変換する)
+  n0 = testCount; e0 = errCount;
+  for (size_t i = 0; i < sizeof(fixCases) / sizeof(fixCases[0]); i++)
+    checkFix(fixCases[i].u, fixCases[i].str);
+  printf("%-28s %10lu 件 不一致 %lu\n", "10のべき乗の直前", testCount - n0, errCount - e0);
+
+  // 32ビット全体(指数表記、0、非正規化数、無限大を含む)
+  sweepFloat("32ビット全体", 0, 0xffffffff, 4099);
+
+  // 整数(intの範囲)
+  n0 = testCount; e0 = errCount;
+  for (n = -100000; n <= 100000; n++)
+    checkInt((long)n);
+  for (n = INT32_MIN; n <= INT32_MAX; n += 9973)
+    checkInt((long)n);
+  checkInt((long)INT32_MIN);
+  checkInt((long)INT32_MAX);
+  printf("%-28s %10lu 件 不一致 %lu\n", "整数", testCount - n0, errCount - e0);
+
+  printf("合計 %lu 件 不一致 %lu 件\n", testCount, errCount);
+  return errCount ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+//
+// ホスト(PC)上のテスト用 Arduino 実行環境の代替(Linux)
+// 2026/10/18 新規作成
+//  シリアル(入力はメモリ上のデータ、出力は標準出力等)、仮想時間、
+//  フラッシュメモリ(0x08000000～を割り付けてページ消去・16ビット書込みを模擬)、仮想EEPROMを提供する
+//
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <sys/mman.h>
+#include "TFlash.h"
+
+#define FLASH_START      0x08000000  // フラッシュメモリ先頭アドレス
+#define FLASH_SIZE       (128*1024)  // フラッシュメモリサイズ
+#define FLASH_PAGE_SIZE  1024        // ページ内バイト数
+#define IDLE_EXIT        2000000     // 入力を使い切った後、終了とみなすまでの入力待ち回数
+
+HostSerial Serial(0);
+HostSerial Serial1(1);
+EEPROMClass EEPROM;
+TFlash_Class TFlash;
+
+static const uint8_t* inBuf;        // 入力データ
+static size_t inLen, inPos;         // 入力データ長、読込み位置
+static uint32_t idle;               // 入力を使い切った後の入力待ち回数
+static FILE* outFp = stdout;        // 出力先
+static uint32_t outBytes;           // 出力バイト数
+static uint32_t fakeTime;           // 仮想時間
+static uint32_t eraseCnt, writeCnt; // フラッシュメモリの消去・書込み回数
+
+// *** 時間、ピン操作 ***
+uint32_t millis() { return fakeTime++ / 16; }
+uint32_t micros() { return fakeTime * 60; }
+void delay(uint32_t ms) { fakeTime += ms * 16; }
+void delayMicroseconds(uint32_t) { }
+void pinMode(int, int) { }
+void digitalWrite(int, int) { }
+int digitalRead(int) { return 0; }
+int analogRead(int) { return 0; }
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout) {
+  char fmt[20];
+  sprintf(fmt, "%%%d.%df", width, prec);
+  sprintf(sout, fmt, val);
+  return sout;
+}
+
+// *** シリアル ***
+void hostSetInput(const char* buf, size_t len) {
+  inBuf = (const uint8_t*)buf;
+  inLen = len;
+  inPos = 0;
+  idle = 0;
+}
+
+void hostSetOutput(FILE* fp) {
+  outFp = fp;
+}
+
+uint32_t hostOutputBytes() {
+  return outBytes;
+}
+
+int HostSerial::available() {
+  if (_no)
+    return 0;
+  if (inPos < inLen)
+    return 1;
+  if (++idle > IDLE_EXIT) {
+    fflush(stdout);
+    exit(0);
+  }
+  return 0;
+}
+
+int HostSerial::read() {
+  if (_no || inPos >= inLen)
+    return -1;
+  return inBuf[inPos++];
+}
+
+int HostSerial::peek() {
+  if (_no || inPos >= inLen)
+    return -1;
+  return inBuf[inPos];
+}
+
+size_t HostSerial::write(uint8_t c) {
+  if (!_no) {
+    outBytes++;
+    if (outFp)
+      fputc(c, outFp);
+  }
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t* buf, size_t n) {
+  if (!_no) {
+    outBytes += n;
+    if (outFp)
+      fwrite(buf, 1, n, outFp);
+  }
+  return n;
+}
+
+// *** フラッシュメモリ ***
+uint8_t hostFlashInit(const char* img) {
+  void* p = mmap((void*)FLASH_START, FLASH_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+  if (p == MAP_FAILED)
+    return 1;
+  memset(p, 0xff, FLASH_SIZE);
+  if (img) {
+    char name[256];
+    FILE* fp = fopen(img, "rb");
+    if (fp) {
+      if (fread(p, 1, FLASH_SIZE, fp) != FLASH_SIZE)
+        memset(p, 0xff, FLASH_SIZE);
+      fclose(fp);
+    }
+    snprintf(name, sizeof(name), "%s.eep", img);
+    fp = fopen(name, "rb");
+    if (fp) {
+      if (fread(EEPROM.vals, sizeof(EEPROM.vals), 1, fp) != 1 || fread(EEPROM.has, sizeof(EEPROM.has), 1, fp) != 1)
+        EEPROM.format();
+      fclose(fp);
+    }
+  }
+  return 0;
+}
+
+uint8_t hostFlashSave(const char* img) {
+  char name[256];
+  FILE* fp = fopen(img, "wb");
+  if (!fp)
+    return 1;
+  fwrite((void*)FLASH_START, 1, FLASH_SIZE, fp);
+  fclose(fp);
+  snprintf(name, sizeof(name), "%s.eep", img);
+  fp = fopen(name, "wb");
+  if (!fp)
+    return 1;
+  fwrite(EEPROM.vals, sizeof(EEPROM.vals), 1, fp);
+  fwrite(EEPROM.has, sizeof(EEPROM.has), 1, fp);
+  fclose(fp);
+  return 0;
+}
+
+uint32_t hostEraseCount() {
+  return eraseCnt;
+}
+
+uint32_t hostWriteCount() {
+  return writeCnt;
+}
+
+TFLASH_Status TFlash_Class::erasePage(uint32_t pageAddress) {
+  uint32_t adr = pageAddress & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+  if (adr < FLASH_START || adr >= FLASH_START + FLASH_SIZE)
+    return TFLASH_BAD_ADDRESS;
+  eraseCnt++;
+  memset((void*)(uintptr_t)adr, 0xff, FLASH_PAGE_SIZE);
+  return TFLASH_COMPLETE;
+}
+
+TFLASH_Status TFlash_Class::write(uint16_t* adr, uint16_t data) {
+  writeCnt++;
+  if (*adr != 0xffff && data != 0)  // 消去状態以外には0のみ書込み可能
+    return TFLASH_ERROR_PG;
+  *adr = data;
+  return TFLASH_COMPLETE;
+}
+
+TFLASH_Status TFlash_Class::write(uint16_t* adr, uint8_t* data, uint16_t len) {
+  TFLASH_Status rc = TFLASH_COMPLETE;
+  for (uint16_t i = 0; i < len && rc == TFLASH_COMPLETE; i += 2)
+    rc = write(adr++, (uint16_t)(data[i] | (i + 1 < len ? data[i+1] << 8 : 0xff00)));  // 端数バイトは上位を0xff
+  return rc;
+}
+
+void TFlash_Class::lock() { }
+void TFlash_Class::unlock() { }
@@ -0,0 +1,100 @@
+//
+// ホスト(PC)上のテスト用 Arduino.h の代替
+// 2026/10/18 新規作成
+// 2026/10/18 インタプリタ全体のビルド用にシリアル、時間、ピン操作の宣言を追加(実体はArduino.cpp)
+//
+
+#ifndef __test_Arduino_h__
+#define __test_Arduino_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+
+#define PROGMEM
+#define __FLASH__
+#define isDigit(c) isdigit(c)
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+// 時間(仮想時間、millis()の呼出しごとに進む)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// ピン操作(何もしない)
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int val);
+int digitalRead(int pin);
+int analogRead(int pin);
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout);
+
+class Print {
+ public:
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n)
+    { size_t r = 0; while (n--) r += write(*buf++); return r; };
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); };
+  size_t print(int v) { char b[16]; sprintf(b, "%d", v); return print(b); };
+  size_t println(const char* s) { return print(s) + print("\r\n"); };
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// シリアルポート(Serial:標準入出力、Serial1:入力なし・出力は捨てる)
+class HostSerial : public Stream {
+ public:
+  HostSerial(uint8_t no) : _no(no) {};
+  void begin(uint32_t) {};
+  void end() {};
+  operator bool() { return true; };
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* buf, size_t n);
+  using Print::write;
+  void flush() {};
+  size_t availableForWrite() { return 64; };
+
+ private:
+  uint8_t _no;
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
+
+// *** ホスト上の実行環境(Arduino.cpp) ***
+// 模擬フラッシュメモリ(0x08000000～の128KB)の割付け
+//  img : 読み込むイメージファイル(NULL:全消去状態)
+// 戻り値 0:正常 1:割付け失敗
+uint8_t hostFlashInit(const char* img);
+uint8_t hostFlashSave(const char* img);   // 模擬フラッシュメモリ、仮想EEPROMの書出し(0:正常)
+uint32_t hostEraseCount();                // ページ消去回数
+uint32_t hostWriteCount();                // ハーフワード書込み回数
+
+// Serialの入力の設定
+//  入力を使い切った後も入力待ちが続く場合は、入力待ちとみなして終了する(exit(0))
+void hostSetInput(const char* buf, size_t len);
+
+// Serialの出力先(NULL:捨てる、出力バイト数のみ数える)
+void hostSetOutput(FILE* fp);
+uint32_t hostOutputBytes();               // Serialへの出力バイト数
+
+#endif
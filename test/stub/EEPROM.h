@@ -0,0 +1,40 @@
+//
+// ホスト(PC)上のテスト用 EEPROM.h の代替(仮想EEPROMをRAM上の表で模擬する)
+// 2026/10/18 新規作成
+//
+
+#ifndef __test_EEPROM_h__
+#define __test_EEPROM_h__
+
+#include <stdint.h>
+#include <string.h>
+
+// 仮想EEPROMステータス(Arduino STM32 のEEPROMライブラリと同じ値)
+#define EEPROM_OK            ((uint16_t)0x0000)
+#define EEPROM_OUT_SIZE      ((uint16_t)0x0081)
+#define EEPROM_BAD_ADDRESS   ((uint16_t)0x0082)
+#define EEPROM_BAD_FLASH     ((uint16_t)0x0083)
+#define EEPROM_NOT_INIT      ((uint16_t)0x0084)
+#define EEPROM_NO_VALID_PAGE ((uint16_t)0x00AB)
+
+class EEPROMClass {
+ public:
+  uint32_t PageBase0;
+  uint32_t PageBase1;
+  uint32_t PageSize;
+  uint16_t vals[65536];  // 値
+  uint8_t  has[65536];   // 1:値あり
+
+  uint16_t read(uint16_t address, uint16_t* data)
+    { if (!has[address]) return EEPROM_BAD_ADDRESS; *data = vals[address]; return EEPROM_OK; };
+  uint16_t write(uint16_t address, uint16_t data)
+    { vals[address] = data; has[address] = 1; return EEPROM_OK; };
+  uint16_t count(uint16_t* data)
+    { *data = 0; return EEPROM_OK; };
+  uint16_t format()
+    { memset(has, 0, sizeof(has)); return EEPROM_OK; };
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
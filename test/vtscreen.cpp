@@ -0,0 +1,243 @@
+//
+// VT100端末の模擬(ホスト上のテスト用)
+// 2026/10/18 新規作成
+//  basic_hostの出力(端末への出力)を読み込み、出力バイト数と最終的な画面の内容・カーソル位置を表示する
+//  画面の描画の変更前後で、出力バイト数を比較し、画面の内容が同じであることを確認する
+//  (文字属性は扱わない、解釈しないエスケープシーケンスは件数を表示する)
+//
+// ビルド・実行(リポジトリのトップで)
+//  g++ -O2 -Wall -Wextra -o vtscreen test/vtscreen.cpp
+//  ./basic_host test/term/printloop.txt | ./vtscreen        (画面は80x24)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VT_ROWS  24  // 行数
+#define VT_COLS  80  // 桁数
+
+static char scr[VT_ROWS][VT_COLS];   // 画面の内容
+static int cy, cx;                   // カーソル位置
+static int top, bot = VT_ROWS - 1;   // スクロール領域
+static int wrapPend;                 // 最終桁に表示後の自動改行待ち
+static int insMode;                  // 挿入モード(IRM)
+static int autoWrap = 1;             // 自動改行(DECAWM)
+static unsigned long unknown;        // 解釈しないエスケープシーケンスの件数
+
+// 行の消去
+static void clearRow(int y, int from) {
+  memset(&scr[y][from], ' ', VT_COLS - from);
+}
+
+// スクロール領域の1行上スクロール(下端に空行)
+static void scrollUp(int y) {
+  memmove(scr[y], scr[y + 1], (bot - y) * VT_COLS);
+  clearRow(bot, 0);
+}
+
+// スクロール領域の1行下スクロール(yに空行)
+static void scrollDown(int y) {
+  memmove(scr[y + 1], scr[y], (bot - y) * VT_COLS);
+  clearRow(y, 0);
+}
+
+// 改行(スクロール領域の下端ではスクロール)
+static void lineFeed() {
+  if (cy == bot)
+    scrollUp(top);
+  else if (cy < VT_ROWS - 1)
+    cy++;
+}
+
+// 1文字表示
+static void putChar(char c) {
+  if (wrapPend && autoWrap) {
+    cx = 0;
+    lineFeed();
+  }
+  wrapPend = 0;
+  if (insMode)
+    memmove(&scr[cy][cx + 1], &scr[cy][cx], VT_COLS - cx - 1);
+  scr[cy][cx] = c;
+  if (cx == VT_COLS - 1)
+    wrapPend = 1;
+  else
+    cx++;
+}
+
+// CSIシーケンスの実行
+//  prm : 引数, n : 引数の数, priv : '?'等の前置文字(0:なし), fin : 終端文字
+static void csi(int* prm, int n, char priv, char fin) {
+  int p1 = n ? prm[0] : 0;
+  int cnt = p1 ? p1 : 1;
+  int lim;
+
+  if (priv == '?') {
+    for (int i = 0; i < n; i++)
+      if (prm[i] == 7)
+        autoWrap = fin == 'h';
+    return;
+  }
+  if (priv) {
+    unknown++;
+    return;
+  }
+  wrapPend = 0;
+  switch (fin) {
+  case 'H': case 'f':
+    cy = (n > 0 && prm[0] ? prm[0] : 1) - 1;
+    cx = (n > 1 && prm[1] ? prm[1] : 1) - 1;
+    if (cy >= VT_ROWS) cy = VT_ROWS - 1;
+    if (cx >= VT_COLS) cx = VT_COLS - 1;
+    break;
+  case 'A':    // スクロール領域内では上端で止まる
+    lim = cy >= top ? top : 0;
+    cy = cy - cnt < lim ? lim : cy - cnt;
+    break;
+  case 'B':    // スクロール領域内では下端で止まる
+    lim = cy <= bot ? bot : VT_ROWS - 1;
+    cy = cy + cnt > lim ? lim : cy + cnt;
+    break;
+  case 'C': cx += cnt; if (cx > VT_COLS - 1) cx = VT_COLS - 1; break;
+  case 'D': cx -= cnt; if (cx < 0) cx = 0; break;
+  case 'G': cx = cnt - 1; if (cx > VT_COLS - 1) cx = VT_COLS - 1; break;
+  case 'd': cy = cnt - 1; if (cy > VT_ROWS - 1) cy = VT_ROWS - 1; break;
+  case 'J':
+    if (p1 == 2)
+      memset(scr, ' ', sizeof(scr));
+    else if (p1 == 0) {
+      clearRow(cy, cx);
+      for (int y = cy + 1; y < VT_ROWS; y++)
+        clearRow(y, 0);
+    } else
+      unknown++;
+    break;
+  case 'K':
+    if (p1 == 0)
+      clearRow(cy, cx);
+    else if (p1 == 2)
+      clearRow(cy, 0);
+    else
+      unknown++;
+    break;
+  case 'r':
+    top = (n > 0 && prm[0] ? prm[0] : 1) - 1;
+    bot = (n > 1 && prm[1] ? prm[1] : VT_ROWS) - 1;
+    cy = cx = 0;
+    break;
+  case 'L':
+    if (cy >= top && cy <= bot)
+      for (int i = 0; i < cnt; i++)
+        scrollDown(cy);
+    cx = 0;
+    break;
+  case 'M':
+    if (cy >= top && cy <= bot)
+      for (int i = 0; i < cnt; i++)
+        scrollUp(cy);
+    cx = 0;
+    break;
+  case 'P':
+    for (int i = 0; i < cnt; i++) {
+      memmove(&scr[cy][cx], &scr[cy][cx + 1], VT_COLS - cx - 1);
+      scr[cy][VT_COLS - 1] = ' ';
+    }
+    break;
+  case '@':
+    for (int i = 0; i < cnt; i++) {
+      memmove(&scr[cy][cx + 1], &scr[cy][cx], VT_COLS - cx - 1);
+      scr[cy][cx] = ' ';
+    }
+    break;
+  case 'h': case 'l':
+    if (p1 == 4)
+      insMode = fin == 'h';
+    else
+      unknown++;
+    break;
+  case 'm':
+    break;
+  default:
+    unknown++;
+  }
+}
+
+// 出力データの解釈
+static void feed(const unsigned char* d, long len) {
+  for (long i = 0; i < len; i++) {
+    unsigned char c = d[i];
+    if (c == 0x1b && i + 1 < len) {
+      char e = d[++i];
+      if (e == '[') {
+        int prm[16], n = 0, v = 0, has = 0;
+        char priv = 0;
+        if (i + 1 < len && (d[i + 1] == '?' || d[i + 1] == '>'))
+          priv = d[++i];
+        while (++i < len && d[i] >= 0x30 && d[i] <= 0x3f) {
+          if (d[i] == ';') {
+            if (n < 16) prm[n++] = v;
+            v = has = 0;
+          } else {
+            v = v * 10 + d[i] - '0';
+            has = 1;
+          }
+        }
+        if (has && n < 16)
+          prm[n++] = v;
+        if (i < len)
+          csi(prm, n, priv, d[i]);
+      } else if (e == 'E') {
+        wrapPend = 0;
+        cx = 0;
+        lineFeed();
+      } else if (e == 'D') {
+        wrapPend = 0;
+        lineFeed();
+      } else if (e == 'M') {
+        wrapPend = 0;
+        if (cy == top)
+          scrollDown(top);
+        else if (cy > 0)
+          cy--;
+      } else if (e == '(' || e == ')') {
+        i++;
+      } else {
+        unknown++;
+      }
+    } else if (c == '\r') {
+      wrapPend = 0;
+      cx = 0;
+    } else if (c == '\n') {
+      wrapPend = 0;
+      lineFeed();
+    } else if (c == '\b') {
+      wrapPend = 0;
+      if (cx > 0)
+        cx--;
+    } else if (c == '\t') {
+      wrapPend = 0;
+      cx = (cx / 8 + 1) * 8;
+      if (cx > VT_COLS - 1)
+        cx = VT_COLS - 1;
+    } else if (c >= 0x20) {
+      putChar(c);
+    }
+  }
+}
+
+int main() {
+  static unsigned char buf[4 * 1024 * 1024];
+  long len = fread(buf, 1, sizeof(buf), stdin);
+
+  memset(scr, ' ', sizeof(scr));
+  feed(buf, len);
+  printf("出力 %ld バイト カーソル %d,%d 未解釈 %lu\n", len, cx, cy, unknown);
+  for (int y = 0; y < VT_ROWS; y++) {
+    int n = VT_COLS;
+    while (n && scr[y][n - 1] == ' ')
+      n--;
+    printf("|%.*s\n", n, scr[y]);
+  }
+  return 0;
+}